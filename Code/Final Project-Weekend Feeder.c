@@ -1,14 +1,77 @@
 #include <stdint.h>
-#include <stdio.h>
 #include <stdbool.h>
 #include "clock.h"
 #include "uart0.h"
 #include "tm4c123gh6pm.h"
 #include "wait.h"
 #include "eeprom.h"
+#include "cycles.h"
+#include "calendar.h"
+#include "format.h"
+#include "packet.h"
+#include "parser.h"
+#include "layout.h"
+#include "schedule.h"
+#include "visitlog.h"
+#include "catchup.h"
+#include "timers.h"
+
+#define REPORT_SIZE 1024
+#define MAX_COMMAND_LENGTH 8        // longest command name ("schedule")
+#define MAX_SLOT (MAX_SLOTS-1)      // feed slots 0-255
+#define MAX_BAUD_ERROR 200          // 2.00 %, largest clock mismatch accepted for a new baud rate
+#define BAUD_CONFIRM_MS 2000        // time the host has to confirm a new baud rate
+#define LOGS_DEFAULT 6              // visits shown by logs / OP_LOGS without a count
+#define LOGS_PACKET_MAX 28          // visits that fit in one OP_LOGS reply
+#define LOGS_CHUNK 16               // visits decoded at a time by logs
+#define SCHEDULE_PAGE 16            // feedings listed per schedule page
+#define SCHEDULE_PACKET_MAX 11      // feedings that fit in one OP_SCHEDULE reply
+#define CONFIG_LINE_WORDS 24        // snapshot words per config load line printed by config dump
+#define CONFIG_PACKET_MAX 28        // snapshot words that fit in one OP_CONFIG_DUMP or OP_CONFIG_LOAD packet
+// Software timers, see timers.c
+#define TIMER_AUGER 0               // stops the auger at the end of a feeding
+#define TIMER_PUMP 1                // stops the pump after a refill or a motion refresh
+#define TIMER_MOTION 2              // motion refresh check
+#define TIMER_LOG 3                 // visit log check
+#define TIMER_WATER 4               // water level measurement
+#define MOTION_PERIOD_MS 2000
+#define LOG_PERIOD_MS 3000
+#define WATER_PERIOD_MS 10000
+#define MOTION_PUMP_MS 1000         // pump run on motion
+#define REFILL_MS 8000              // pump run when the level is under the set volume in auto mode
+
+// receiveSnapshot results
+#define CONFIG_PENDING 0            // chunk stored, more expected
+#define CONFIG_LOADED 1             // last chunk stored and the snapshot loaded
+#define CONFIG_INVALID 2            // chunk out of order or snapshot refused, nothing changed
+
+// Binary protocol opcodes, same operations as the text shell commands
+#define OP_TIME_SET         0x01    // u32 seconds since 1970-01-01 00:00 local time
+#define OP_TIME_GET         0x02    // reply: u32 seconds
+#define OP_FEED_ADD         0x03    // u8 index, u8 duration, u8 pwm, u8 hour, u8 minute, [u8 weekdays (bit 0 Sunday),
+                                    //  [u16 first day, u16 last day (days since 1970-01-01, 0xFFFF no end)]]
+#define OP_FEED_DELETE      0x04    // u8 index
+#define OP_WATER_SET        0x05    // u16 level
+#define OP_WATER_GET        0x06    // reply: u16 refill level, u16 water level, u32 ticks
+#define OP_FILL             0x07    // u8 mode (1 auto, 0 motion)
+#define OP_ALERT            0x08    // u8 (1 on, 0 off)
+#define OP_LOGS             0x09    // [u8 count], reply: u16 visits stored, count x u32 visit times (newest first)
+#define OP_SCHEDULE         0x0A    // [u8 page], reply: u16 feedings stored, up to 11 x (u8 index, u8 duration,
+                                    //  u8 pwm, u8 hour, u8 minute, u8 weekdays, u16 first day, u16 last day)
+                                    //  in time order, u32 next alarm (0xFFFFFFFF none)
+#define OP_TEXT             0x0B    // leave binary mode
+#define OP_CONFIG_DUMP      0x0C    // u16 offset, reply: u16 snapshot words, up to 28 x u32 snapshot words from offset
+#define OP_CONFIG_LOAD      0x0D    // u16 offset, up to 28 x u32 snapshot words, reply: u8 (1 loaded, 0 more expected)
+#define OP_CATCHUP          0x0E    // [u8 policy (0 run, 1 merge, 2 skip)], reply: u8 policy, u32 last feeding run,
+                                    //  u16 feedings missed at the last check
+
+// Binary protocol reply status
+#define STATUS_OK           0
+#define STATUS_BAD_OPCODE   1
+#define STATUS_BAD_LENGTH   2
+#define STATUS_BAD_CONFIG   3       // snapshot refused, nothing changed
+#define STATUS_NO_RANGE     4       // date range refused (table full or ends before it starts), nothing changed
 
-#define MAX_CHARS 80
-#define MAX_FIELDS 6
 #define GREEN_LED_MASK 8    // PF3
 #define AUDIO_MASK 32       // PE5
 #define MOTOR_MASK 16       // PC4
@@ -33,30 +96,51 @@
 // Global variables
 //-----------------------------------------------------------------------------
 uint32_t Ticks = 0;
+uint32_t chargeStart;               // cycle counter when the dish capacitance starts charging
 uint16_t waterLvl;
-int nextEventIndex;
+int nextEventIndex = -1;            // slot armed in RTCM0, -1 when nothing is left to feed
 int modeSet;
 int alert;
 int prevTicks = 0;
 uint32_t volume;
 int block = 1;
-int index = 6;
 int prevCC = -1;
-char str[100];
-
-typedef struct _USER_DATA
+char report[REPORT_SIZE];          // bulk shell output, sent by uDMA straight from this buffer
+volatile bool reportBusy = false;
+bool binaryMode = false;
+uint32_t snapshot[SNAPSHOT_MAX_WORDS];  // config dump output and the config load chunks received so far
+uint16_t snapshotLength = 0;            // words of a config load received so far
+bool textFlowControl = false;       // XON/XOFF setting of the text shell, restored when binary mode ends
+bool deferSchedule = false;         // set while a batch of commands runs
+bool scheduleDirty = false;         // next feeding must be recomputed at the end of the batch
+FRAME_RX frameRx;                   // binary mode receive frame
+uint32_t nextEventCycles = 0;       // cpu cycles of the last and slowest setNextEvent
+uint32_t maxNextEventCycles = 0;
+uint32_t maxLogIsrCycles = 0;       // slowest logVisit, log writes are queued so this excludes EEPROM programming
+uint32_t validateCycles = 0;        // boot time crc check of the EEPROM regions
+
+typedef struct _COMMAND
 {
-    char buffer[MAX_CHARS+1];
-    uint8_t fieldCount;
-    uint8_t fieldPosition[MAX_FIELDS];
-    char fieldType[MAX_FIELDS];
-} USER_DATA;
+    const char* name;
+    uint8_t minArgs;
+    uint8_t maxArgs;
+    const char* argTypes;           // one type per argument, see commands[]
+    void (*handler)(USER_DATA* data);
+} COMMAND;
+
 
 
+// sets the NVIC priority (0 highest, 7 lowest) of interrupt number irq (INT_ value)
+void setInterruptPriority(uint8_t irq, uint8_t priority)
+{
+    volatile uint8_t* pri = (volatile uint8_t*)&NVIC_PRI0_R;
+    pri[irq-16] = priority << 5;
+}
 
 // Initialize Hardware
 void initHw()
 {
+    initCycleCounter();
     initUart0();
     setUart0BaudRate(115200, 40e6);
 
@@ -73,27 +157,24 @@ void initHw()
     //Enable Comparator 0
     SYSCTL_RCGCACMP_R   |= SYSCTL_RCGCACMP_R0;
 
-    // Enable wide timer clocks
-    SYSCTL_RCGCWTIMER_R |= SYSCTL_RCGCWTIMER_R1 | SYSCTL_RCGCWTIMER_R0;
-
-    // Enable time clk
-    SYSCTL_RCGCTIMER_R |= SYSCTL_RCGCTIMER_R4 | SYSCTL_RCGCTIMER_R3 | SYSCTL_RCGCTIMER_R2 | SYSCTL_RCGCTIMER_R1
-                            | SYSCTL_RCGCTIMER_R0;
-
     _delay_cycles(3);
 
     // Enable EEPROM Module
     initEeprom();
 
-    // Config Hibernation
+    // Config Hibernation, an RTC still counting on VBAT through the reset keeps its time
+    bool rtcKept = (HIB_CTL_R & (HIB_CTL_CLK32EN | HIB_CTL_RTCEN)) == (HIB_CTL_CLK32EN | HIB_CTL_RTCEN);
     while(HIB_CTL_WRC & ~HIB_CTL_R);
     HIB_CTL_R   |= HIB_CTL_CLK32EN | HIB_CTL_RTCEN;         // sets clock to  32.768-kHz Hibernation oscillator
                                                             // and enable the RTC to begin counting
     while(HIB_CTL_WRC & ~HIB_CTL_R);
     HIB_IM_R    |= HIB_IM_RTCALT0;                          // set HIB interupt mask
     // Set the required RTC match interrupt mask in the RTCALT0
-    while(HIB_CTL_WRC & ~HIB_CTL_R);
-    HIB_RTCLD_R = 0;                                        // inti the counter to 0
+    if(!rtcKept)
+    {
+        while(HIB_CTL_WRC & ~HIB_CTL_R);
+        HIB_RTCLD_R = 0;                                    // inti the counter to 0
+    }
     while(HIB_CTL_WRC & ~HIB_CTL_R);
     NVIC_EN1_R = 1 << (INT_HIBERNATE-16-32);
 
@@ -113,13 +194,8 @@ void initHw()
     GPIO_PORTB_DIR_R &= ~SENSOR_MASK;   // bits 1 and 3 are outputs, other pins are inputs
     GPIO_PORTB_DEN_R |= SENSOR_MASK;    // enable LEDs and
 
-    //wide timer 1A
-    WTIMER1_CTL_R &= ~TIMER_CTL_TAEN;                 // turn-off timer before reconfiguring
-    WTIMER1_TAMR_R = TIMER_TAMR_TAMR_PERIOD;          // configure for periodic mode (count down)
-    WTIMER1_TAILR_R = 400000000;                      // set load value to 40e7 for 100 mHz (10 secs) interrupt rate
-    WTIMER1_IMR_R = TIMER_IMR_TATOIM;                 // turn-on interrupts for timeout in timer module
-    NVIC_EN3_R = 1 << (INT_WTIMER1A-16-96);           // turn-on interrupt 112 (WTIMER1A) in NVIC
-    WTIMER1_CTL_R |= TIMER_CTL_TAEN;                  // turn-on timer
+    // Software timers on timer 0
+    initTimers();
 
     // C0
     GPIO_PORTC_DIR_R    &= ~PC7_MASK;
@@ -135,9 +211,6 @@ void initHw()
     COMP_ACCTL0_R |= COMP_ACCTL0_CINV;
     COMP_ACCTL0_R |= COMP_ACCTL0_ISEN_RISE;
 
-    WTIMER0_CTL_R &= ~TIMER_CTL_TAEN;                 // turn-off timer before reconfiguring
-    WTIMER0_TAMR_R = TIMER_TAMR_TAMR_1_SHOT | TIMER_TAMR_TACDIR;
-
     SYSCTL_RCGCPWM_R |= SYSCTL_RCGCPWM_R0;
     SYSCTL_RCGCGPIO_R |= SYSCTL_RCGCGPIO_R2;
     _delay_cycles(3);
@@ -165,203 +238,66 @@ void initHw()
     PWM0_3_CTL_R = PWM_0_CTL_ENABLE;                 // turn-on PWM0 generator 3
     PWM0_ENABLE_R = PWM_ENABLE_PWM6EN | PWM_ENABLE_PWM7EN;
                                                          // enable outputs
-}
-
-// getsUart0 gets input from PuTTY which only can be alphabet, 'ENTER', 'BACKSPACE', and numerical
-void getsUart0(USER_DATA *data)
-{
-    int count = 0;
-    char c;
 
-    while(true)
-    {
-        c = getcUart0();
-        if((c == 8 || c==127) && count>0)
-        {
-            count--;
-        }
-        else if(c == 13)
-        {
-            data->buffer[count] = 0;
-            return;
-        }
-        else if(c >= 32)
-        {
-            data->buffer[count] = c;
-            count++;
-            if(count == MAX_CHARS)
-            {
-                data->buffer[count] = 0;
-                return;
-            }
-        }
-    }
+    // UART0 stays at priority 0 so it can preempt the other isrs (the buzzer loop blocks for 2 s)
+    //  and the rx fifo does not overrun while they run
+    // the software timers run below the comparator so a callback due on the same tick as
+    //  measureWater cannot add to the charge time it measures
+    setInterruptPriority(INT_TIMER0A, 2);
+    setInterruptPriority(INT_COMP0, 1);
+    setInterruptPriority(INT_HIBERNATE, 1);
 }
 
-//  puts null anywhere except numerical or alphabet, sets field type and count and position
-void parseFields(USER_DATA *data)
-{
-    int bufferIndex = 0, fieldIndex = 0;
-    bool flag = 0;
-    data->fieldCount = 0;
-    while(data->buffer[bufferIndex])
-    {
-        if(data->fieldCount == MAX_FIELDS)
-        {
-            return;
-        }
-        if(((data->buffer[bufferIndex] >= 65) && (data->buffer[bufferIndex] <= 90)) ||
-                ((data->buffer[bufferIndex] >= 97) && (data->buffer[bufferIndex] <= 122)))
-        {
-            if(!flag)
-            {
-                (data->fieldCount)++;
-                data->fieldPosition[fieldIndex] = bufferIndex;
-                data->fieldType[fieldIndex] = 97; // 'a'
-                flag = 1;
-                fieldIndex++;
-            }
-        }
-        else if(data->buffer[bufferIndex] >= 48 && data->buffer[bufferIndex] <= 57)
-        {
-            if(!flag)
-            {
-                (data->fieldCount)++;
-                data->fieldPosition[fieldIndex] = bufferIndex;
-                data->fieldType[fieldIndex] = 'n'; // 110
-                flag = 1;
-                fieldIndex++;
-            }
-        }
-        else
-        {
-            flag = 0;
-            data->buffer[bufferIndex] = 0;
-        }
-
-        bufferIndex++;
-    }
-}
-
-// checks if asked fieldNumber is alpha, if so returns it address
-char* getFieldString(USER_DATA* data, uint8_t fieldNumber)
-{
-    if((fieldNumber < data->fieldCount ) && (data->fieldType[fieldNumber] == 'a'))
-    {
-        return &(data->buffer[data->fieldPosition[fieldNumber]]);
-    }
-    return 0;
-}
-
-// checks if asked fieldNumber is numerical, if so converts the value from string to integer and returns it
-uint32_t getFieldInteger(USER_DATA* data, uint8_t fieldNumber)
-{
-    if((fieldNumber < data->fieldCount) && (data->fieldType[fieldNumber] == 'n'))
-    {
-        uint32_t returnNum = 0;
-        char* number = &data->buffer[data->fieldPosition[fieldNumber]];
-        int i = 0;
-        while(number[i])
-        {
-            int num = (number[i]-48);
-            if(i)
-            {
-                returnNum *= 10;
-            }
-            returnNum += num;
-            i++;
-        }
-        return returnNum;
-    }
-    return 0;
-}
-
-// checks command validation from data (1st argument) with passed string, also checks valid arguments
-bool isCommand(USER_DATA* data, const char strCommand[], uint8_t minArguments)
-{
-    if(data->fieldCount >= minArguments+1) // plus 1 because fieldCount-1 for command
-    {
-        int i = 0;
-        char* buffStr = &(data->buffer[data->fieldPosition[0]]);
-        while(strCommand[i])
-        {
-            if(buffStr[i] != strCommand[i])
-            {
-                return false;
-            }
-            i++;
-        }
-        return true;
-    }
-    return false;
-}
-
-// 10 seconds period interrupt that turns on GPO (discharges pet dish capacitance) and turns on another
-//    timer which measures clock time and stops on analog comparator interrupt (happens when pet
+// 10 seconds period timer that turns on GPO (discharges pet dish capacitance) and notes the cycle
+//    counter, the analog comparator interrupt measures the clock time from there (happens when pet
 //      dish capacitance charges up to 2.469 Volts)
-void wideTimer1Isr()
+void measureWater()
 {
     BLUE_LED ^= 1;
     FET_DRAIN = 1;
     waitMicrosecond(100);
     FET_DRAIN = 0;
 
-    WTIMER0_TAV_R = 0;
-    WTIMER0_CTL_R |= TIMER_CTL_TAEN;                  // turn-on widetimer0A
+    chargeStart = readCycleCounter();
 
     COMP_ACINTEN_R |= COMP_ACINTEN_IN0;
     NVIC_EN0_R = 1 << (INT_COMP0-16);
-
-    WTIMER1_ICR_R = TIMER_ICR_TATOCINT;               // clear interrupt flag for wt1a
 }
 
 // turns off Pump
-void timer3Isr(){
+void stopPump(){
     PWM0_3_CMPB_R = 0;
-    TIMER3_ICR_R = TIMER_ICR_TATOCINT;
 }
 
-// configures an interrupt that fill pet dish with pump for 8 seconds
-//  refill is only called in auto mode (refill under certain level)
-void refill(){
-    TIMER3_CTL_R &= ~TIMER_CTL_TAEN;                 // turn-off timer before reconfiguring
-    TIMER3_CFG_R = TIMER_CFG_32_BIT_TIMER;           // configure as 32-bit timer (A+B)
-    TIMER3_TAMR_R = TIMER_TAMR_TAMR_1_SHOT;          // configure as one shot timer
-
-    TIMER3_TAILR_R = (40000000*8);                   // set load value to 40e6 for 1 Hz interrupt rate
+// runs the pump for ms milliseconds, a run already going ends at the later of its end and ms from now
+//  (a motion refresh must not cut a refill short)
+void runPump(uint32_t ms){
     PWM0_3_CMPB_R = 1023;
+    extendOneShotTimer(TIMER_PUMP, ms, stopPump);
+}
 
-    TIMER3_IMR_R = TIMER_IMR_TATOIM;                 // turn-on interrupts for timeout in timer module
-    TIMER3_CTL_R |= TIMER_CTL_TAEN;                  // turn-on timer
-    NVIC_EN1_R = 1 << (INT_TIMER3A-16-32);           // turn-on interrupt 37 (TIMER1A) in NVIC
+// fills pet dish with pump for 8 seconds
+//  refill is only called in auto mode (refill under certain level)
+void refill(){
+    runPump(REFILL_MS);
 }
 
-// 2 seconds periodic interrupt initiated when mode is switched to motion
+// 2 seconds periodic timer started when mode is switched to motion
 //  on capture by motion sensor water is 'freshed'
-void timer0Isr(){
-    // Configure Timer 1 as the time base
+void checkMotion(){
     if(SENSOR && !modeSet)                       // motion refill
     {
-        TIMER2_CTL_R &= ~TIMER_CTL_TAEN;                 // turn-off timer before reconfiguring
-        TIMER2_CFG_R = TIMER_CFG_32_BIT_TIMER;           // configure as 32-bit timer (A+B)
-        TIMER2_TAMR_R = TIMER_TAMR_TAMR_1_SHOT;           // config as one shot timer
-        TIMER2_TAILR_R = 40000000 ;                  // set load value to 40e6 for 1 Hz interrupt rate
-        PWM0_3_CMPB_R = 1023;
-        TIMER2_IMR_R = TIMER_IMR_TATOIM;                 // turn-on interrupts for timeout in timer module
-        TIMER2_CTL_R |= TIMER_CTL_TAEN;                  // turn-on timer
-        NVIC_EN0_R = 1 << (INT_TIMER2A-16);              // turn-on interrupt 37 (TIMER1A) in NVIC
+        runPump(MOTION_PUMP_MS);
     }
-    TIMER0_ICR_R = TIMER_ICR_TATOCINT;               // clear interrupt flag
 }
 
 // Analog comparator interrupt that gets clock time of pet dish capacitance charging
 //      with many experiments ranges are created of 50 mL sensitivity
 //An equation was derived but not accurate due to clock time not being linear in proportion to water quantity
 // Interrupt also sets alert on water not being filled with minimum requirement
-void wideTimer0Isr()
+void comparator0Isr()
 {
-    Ticks = WTIMER0_TAV_R;              // read counter input
-    WTIMER0_CTL_R &= ~TIMER_CTL_TAEN;   // turn-off event counter
+    Ticks = readCycleCounter() - chargeStart;   // system clocks, as wide timer 0 counted before
     COMP_ACMIS_R = COMP_ACMIS_IN0;  // clear interrupt flag
 
 /*    if(Ticks < 3000){
@@ -422,286 +358,1151 @@ void wideTimer0Isr()
     prevTicks = Ticks;
 }
 
-// Hibernate interrupt occurs when RTC_M0 (set by next event which user puts in) equals RTC_CC (current time),
-//  (time to put food in the dish) Auger is turned on based on user input in EEprom
-void hibIsr(){
-    uint32_t on = readEeprom(16*nextEventIndex+1);
-    float dutyCyc = (float)readEeprom(16*nextEventIndex+2); // Configure Timer 1 as the time base
-    TIMER1_CTL_R &= ~TIMER_CTL_TAEN;                        // turn-off timer before reconfiguring
-    TIMER1_CFG_R = TIMER_CFG_32_BIT_TIMER;                  // configure as 32-bit timer (A+B)
-    TIMER1_TAMR_R = TIMER_TAMR_TAMR_1_SHOT;                 // config as one shot timer
-    TIMER1_TAILR_R = 40000000*on;                           // set load value to 40e6 for 1 Hz interrupt rate
-    TIMER1_IMR_R = TIMER_IMR_TATOIM;                        // turn-on interrupts for timeout in timer module
+// uDMA completion callback, report buffer may be reused
+void reportSent()
+{
+    reportBusy = false;
+}
 
-    PWM0_3_CMPA_R = (uint32_t)(1023.0*(float)(dutyCyc/100));
-    TIMER1_CTL_R |= TIMER_CTL_TAEN;                         // turn-on timer
-    NVIC_EN0_R = 1 << (INT_TIMER1A-16);                     // turn-on interrupt 37 (TIMER1A) in NVIC
+// sends the first length bytes of report by uDMA, report must not be written again until reportBusy clears
+void sendReport(uint16_t length)
+{
+    reportBusy = true;
+    while(!putsUart0Dma(report, length, reportSent));
+}
 
-    HIB_IC_R = HIB_RIS_RTCALT0;
+// keeps the cost of the last and slowest alarm update for perf
+void recordNextEventCycles(uint32_t start)
+{
+    nextEventCycles = readCycleCounter() - start;
+    if(nextEventCycles > maxNextEventCycles)
+    {
+        maxNextEventCycles = nextEventCycles;
+    }
 }
 
-// setNextEvent finds the next closest time compared to RTCM0 from the EEPROM
-//      If closest time not found, resets to smallest time (earliest hour)
-void setNextEvent(){
+// arms RTCM0 with the first feeding after seconds (RTC seconds), weekdays and date ranges are resolved
+//  by findNextFeed() without stepping through the days, RTCM0 is parked at the end of time when
+//  nothing is left to feed
+void armNextEvent(uint32_t seconds)
+{
+    uint32_t when = 0xFFFFFFFF;
+    nextEventIndex = findNextFeed(seconds, FEED_CURSOR_END, &when);
+    if(nextEventIndex < 0)
+    {
+        when = 0xFFFFFFFF;
+    }
     while(HIB_CTL_WRC & ~HIB_CTL_R);
-    uint32_t days = (HIB_RTCC_R/3600)/24;
+    HIB_RTCM0_R = when;
+}
+
+// setNextEvent arms the first feeding after the current time
+//      hibIsr re-arms RTCM0 too, it must not run between the time read and the alarm written
+void setNextEvent(){
+    uint32_t start = readCycleCounter();
+    uint32_t state;
+
+    scheduleDirty = false;
+    state = _disable_interrupts();
     while(HIB_CTL_WRC & ~HIB_CTL_R);
-    uint32_t cur = HIB_RTCC_R-(days*86400);       // seconds, 24*3600 is 86,400
-    uint32_t nextEvent = 0;
-    bool nextFound = 0;
-    int i;
+    armNextEvent(HIB_RTCC_R);
+    _restore_interrupts(state);
+    recordNextEventCycles(start);
+}
 
-    for(i=0; i<10; i++){
-        if(readEeprom(16*i)<10){
-            uint32_t sec = readEeprom(16*i+3)*3600+readEeprom(16*i+4)*60;
-            if(sec > cur){
-                if(nextEvent == 0 || sec < nextEvent)
-                {
-                    nextEvent = sec;
-                    nextFound = 1;
-                    nextEventIndex = i;
-                    while(HIB_CTL_WRC & ~HIB_CTL_R);
-                    HIB_RTCM0_R = nextEvent+(days*86400);
-                }
-            }
-        }
-    }
+// arms the first feeding later than the alarm that just matched, called from hibIsr
+//      feedings at the same time cannot be armed, their match has passed, hibIsr runs them in turn
+//      a command batch that changed the schedule re-arms it when it ends instead
+void advanceNextEvent(){
+    uint32_t start = readCycleCounter();
 
-   if(!nextFound)
+    if(scheduleDirty)
     {
-        cur = 0;
-        for(i=0; i<10; i++){
-            if(readEeprom(16*i)<10){
-                uint32_t sec = readEeprom(16*i+3)*3600+readEeprom(16*i+4)*60;
-                if(sec > cur){
-                    if(nextEvent == 0 || sec < nextEvent)
-                    {
-                        nextEvent = sec;
-                        nextEventIndex = i;
-                    }
-                }
-            }
-        }
-        while(HIB_CTL_WRC & ~HIB_CTL_R);
-        HIB_RTCM0_R = nextEvent+(days*86400);
+        return;
     }
-    return;
+    armNextEvent(HIB_RTCM0_R);
+    recordNextEventCycles(start);
 }
 
-// turns off Pump
-void timer2Isr(){
-    PWM0_3_CMPB_R = 0;
-    TIMER2_ICR_R = TIMER_ICR_TATOCINT;
+void stopFeeding();
+
+// runs the auger for duration seconds at pwm percent, stopFeeding turns it off
+void startFeeding(uint32_t duration, uint32_t pwm)
+{
+    float dutyCyc = (float)pwm;
+    PWM0_3_CMPA_R = (uint32_t)(1023.0*(float)(dutyCyc/100));
+    startOneShotTimer(TIMER_AUGER, 1000*duration, stopFeeding);
+}
+
+// Hibernate interrupt occurs when RTC_M0 (set by next event which user puts in) equals RTC_CC (current time),
+//  (time to put food in the dish) Auger is turned on based on user input in EEprom
+//  every feeding at the alarm's time runs, one after the other, after any still running or due
+//  a match left pending while setNextEvent moved the alarm later is ignored
+void hibIsr(){
+    if(nextEventIndex < 0 || HIB_RTCC_R < HIB_RTCM0_R)
+    {
+        HIB_IC_R = HIB_RIS_RTCALT0;
+        return;
+    }
+    runAlarmFeeds(HIB_RTCM0_R);
+
+    advanceNextEvent();
+    HIB_IC_R = HIB_RIS_RTCALT0;
 }
 
-// turns off Auger
-void timer1Isr(){
+// turns off Auger and starts the next feeding due, if any
+void stopFeeding(){
     PWM0_3_CMPA_R = 0;
-    TIMER1_ICR_R = TIMER_ICR_TATOCINT;               // clear interrupt flag
-    setNextEvent();
+    endFeeding();
+}
+
+// initiates 10 second periodic timer for measuring the water level
+void init10secWater(){
+    startPeriodicTimer(TIMER_WATER, WATER_PERIOD_MS, measureWater);
 }
 
-// initiates 2 second periodic interrupt for checking motion
+// initiates 2 second periodic timer for checking motion
 void init2secMotion(){
-    TIMER0_CTL_R &= ~TIMER_CTL_TAEN;                 // turn-off timer before reconfiguring
-    TIMER0_CFG_R = TIMER_CFG_32_BIT_TIMER;           // configure as 32-bit timer (A+B)
-    TIMER0_TAMR_R = TIMER_TAMR_TAMR_PERIOD;          // configure for periodic mode (count down)
-    TIMER0_TAILR_R = 40000000*2;                     // set load value to 40e6 for 1 Hz interrupt rate
-    TIMER0_IMR_R = TIMER_IMR_TATOIM;                 // turn-on interrupts for timeout in timer module
-    TIMER0_CTL_R |= TIMER_CTL_TAEN;                  // turn-on timer
-    NVIC_EN0_R = 1 << (INT_TIMER0A-16);              // turn-on interrupt 19 (TIMER0A) in NVIC
+    startPeriodicTimer(TIMER_MOTION, MOTION_PERIOD_MS, checkMotion);
 }
 
 // stores pets logs (notes down time when pet visits the dish) in EEprom
-//  does not store time of same minute
-void timer4ISR(){
+//  does not store time of same minute, the write is queued and programmed by the main loop
+void logVisit(){
+    uint32_t start = readCycleCounter();
     if(SENSOR){
         while(HIB_CTL_WRC & ~HIB_CTL_R);
         uint32_t CC = HIB_RTCC_R;
         if(CC/60 != prevCC){
-            if(index != 12){
-                writeEeprom(16*1+index, CC);
-                ++index;
-            }
-            else if(index == 12){
-                index = 6;
-                writeEeprom(16*1+index, CC);
-                ++index;
-            }
+            appendVisit(CC);
         }
         prevCC = CC/60;
     }
-    TIMER4_ICR_R = TIMER_ICR_TATOCINT;
+    start = readCycleCounter() - start;
+    if(start > maxLogIsrCycles)
+    {
+        maxLogIsrCycles = start;
+    }
 }
 
-// Period 3 second interrupt to check pet visit to the dish
+// Period 3 second timer to check pet visit to the dish
 void init3seclog()
 {
-    TIMER4_CTL_R &= ~TIMER_CTL_TAEN;                 // turn-off timer before reconfiguring
-    TIMER4_CFG_R = TIMER_CFG_32_BIT_TIMER;           // configure as 32-bit timer (A+B)
-    TIMER4_TAMR_R = TIMER_TAMR_TAMR_PERIOD;          // configure for periodic mode (count down)
-    TIMER4_TAILR_R = 40000000*3;                     // set load value to 40e6 for 1 Hz interrupt rate
-    TIMER4_IMR_R = TIMER_IMR_TATOIM;                 // turn-on interrupts for timeout in timer module
-    TIMER4_CTL_R |= TIMER_CTL_TAEN;                  // turn-on timer
-    NVIC_EN2_R = 1 << (INT_TIMER4A-16-64);              // turn-on interrupt 96 (TIMER4A) in NVIC
+    startPeriodicTimer(TIMER_LOG, LOG_PERIOD_MS, logVisit);
 }
-//-----------------------------------------------------------------------------
-// Main
-//-----------------------------------------------------------------------------
-// Controls all input command and initialization
-int main(void)
+// recomputes the next feeding now, or at the end of the current command batch
+void updateSchedule()
 {
-    uint32_t x;
-    // Initialize hardware
-    initHw();
-    initUart0();
-    USER_DATA data;
-    init2secMotion();
-    init3seclog();
-    alert = readEeprom(7);
-    modeSet = readEeprom(6);
-    volume = readEeprom(5);
-    while(true)
+    if(deferSchedule)
+    {
+        scheduleDirty = true;
+    }
+    else
+    {
+        setNextEvent();
+    }
+}
+
+// sets the RTC to seconds, catches up on the feedings it skips and re-arms the next feeding
+void setTime(uint32_t seconds)
+{
+    while(HIB_CTL_WRC & ~HIB_CTL_R);
+    HIB_RTCLD_R = seconds;
+    catchUpFeeds(seconds);
+    updateSchedule();
+}
+
+// stores a feeding (auger on time, PWM, time of day, weekdays and date range) in slot block
+//  returns false if the date range was refused, the slot is then unchanged
+bool addFeed(uint16_t block, uint32_t duration, uint32_t pwm, uint32_t hour, uint32_t minute, uint32_t days,
+        uint32_t firstDay, uint32_t lastDay)
+{
+    //  sets flag to index, and data to others
+    FEED_SLOT feed = {block, duration, pwm, hour, minute, days, firstDay, lastDay};
+    if(!writeFeedSlot(block, &feed))
+    {
+        return false;
+    }
+    updateSchedule();                           // updates feeding time
+    return true;
+}
+
+// removes the feeding in slot block
+void deleteFeed(uint16_t block)
+{
+    // places 11 for unavaliable index and 0 for data
+    clearFeedSlot(block);
+    updateSchedule();                           // recalibrates next feeding time
+}
+
+// stores one config word, the region crc covers volume, fill mode and alert together
+void writeConfig(uint16_t add)
+{
+    uint32_t config[3] = {volume, modeSet, alert};
+    writeRegionWord(REGION_CONFIG, config, add);
+}
+
+void setVolume(uint32_t level)
+{
+    volume = level;
+    writeConfig(EE_VOLUME);
+}
+
+// 1 is auto refill, 0 is motion freshen up
+void setFillMode(int mode)
+{
+    modeSet = mode;
+    writeConfig(EE_FILL_MODE);
+}
+
+void setAlert(int on)
+{
+    alert = on;
+    writeConfig(EE_ALERT);
+}
+
+// reads volume, fill mode and alert from EEPROM
+void loadConfig()
+{
+    uint32_t config[3];
+    readEepromBlock(EE_VOLUME, config, 3);
+    volume = config[0];
+    modeSet = config[1];
+    alert = config[2];
+}
+
+// replaces the schedule and config with a snapshot of length words, then re-arms the next feeding once
+//  returns the importSnapshot result, nothing changed unless it is IMPORT_DONE
+uint8_t loadSnapshot(const uint32_t* snapshot, uint16_t length)
+{
+    uint8_t result = importSnapshot(snapshot, length);
+    if(result != IMPORT_DONE)
+    {
+        return result;
+    }
+    loadSchedule();
+    loadConfig();
+    updateSchedule();
+    return IMPORT_DONE;
+}
+
+// switches uart0 to baudRate if the host confirms it: the reply is sent at the old rate, then the host
+//  has BAUD_CONFIRM_MS to send "ok" at the new rate, otherwise the old rate is restored
+void negotiateBaudRate(USER_DATA* data, uint32_t baudRate)
+{
+    uint32_t oldRate = getUart0BaudRate();
+    uint32_t actual, divisorTimes64;
+    int32_t error;
+    bool highSpeed;
+    int ms;
+
+    actual = calcUart0BaudRate(baudRate, 40e6, &divisorTimes64, &highSpeed);
+    error = calcUart0BaudError(baudRate, actual);
+    putsUart0("baud ");
+    putuUart0(actual, 1);
+    putsUart0(" error ");
+    if(error < 0)
+    {
+        putcUart0('-');
+        error = -error;
+    }
+    putuUart0(error / 100, 1);
+    putcUart0('.');
+    putuUart0(error % 100, 2);
+    putsUart0("%\n");
+    if(actual == 0 || error > MAX_BAUD_ERROR)
+    {
+        putsUart0("baud unchanged\n");
+        return;
+    }
+
+    setUart0BaudRate(baudRate, 40e6);          // drains the reply at the old rate before switching
+    waitMicrosecond(1000);                      // let the host reprogram its side
+    flushUart0Rx();                             // drop anything garbled by the switch
+    data->charCount = 0;
+    for(ms = 0; ms < BAUD_CONFIRM_MS; ms++)
+    {
+        if(getsUart0NonBlocking(data))
+        {
+            if(data->buffer[0] == 'o' && data->buffer[1] == 'k' && data->buffer[2] == 0)
+            {
+                putsUart0("baud ok\n");
+                return;
+            }
+        }
+        waitMicrosecond(1000);
+    }
+    setUart0BaudRate(oldRate, 40e6);            // no confirmation, fall back
+    flushUart0Rx();
+    data->charCount = 0;
+    putsUart0("baud unchanged\n");
+}
+
+// little endian helpers for binary packets
+uint32_t getPacketWord(const uint8_t* p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+uint8_t* putPacketWord(uint8_t* p, uint32_t value)
+{
+    *p++ = value;
+    *p++ = value >> 8;
+    *p++ = value >> 16;
+    *p++ = value >> 24;
+    return p;
+}
+
+uint16_t getPacketHalf(const uint8_t* p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+uint8_t* putPacketHalf(uint8_t* p, uint16_t value)
+{
+    *p++ = value;
+    *p++ = value >> 8;
+    return p;
+}
+
+// stores count little endian words of a config load at offset, offset 0 starts a new snapshot
+//  chunks must arrive in order, the counts in the header give the length and the snapshot is
+//  loaded as soon as its last word is in
+uint8_t receiveSnapshot(uint16_t offset, const uint8_t* bytes, uint16_t count)
+{
+    uint16_t length;
+    int i;
+
+    if(offset == 0)
+    {
+        snapshotLength = 0;
+    }
+    if(offset != snapshotLength || count > SNAPSHOT_MAX_WORDS - offset)
+    {
+        snapshotLength = 0;
+        return CONFIG_INVALID;
+    }
+    for(i = 0; i < count; i++)
+        snapshot[snapshotLength++] = getPacketWord(&bytes[4*i]);
+    if(snapshotLength <= SNAPSHOT_RANGES)
     {
-        bool valid = false;
-        getsUart0(&data);       //  Get the string from the user
-        parseFields(&data);     //  Takes the
+        return CONFIG_PENDING;
+    }
+    length = getSnapshotLength(snapshot);
+    if(length == 0)
+    {
+        snapshotLength = 0;
+        return CONFIG_INVALID;
+    }
+    if(snapshotLength < length)
+    {
+        return CONFIG_PENDING;
+    }
+    snapshotLength = 0;
+    if(offset + count != length)
+    {
+        return CONFIG_INVALID;
+    }
+    return loadSnapshot(snapshot, length) == IMPORT_DONE ? CONFIG_LOADED : CONFIG_INVALID;
+}
 
-        if(isCommand(&data, "time", 2))
+// executes one binary request and sends the framed reply
+void processPacket(uint8_t* packet, uint16_t length)
+{
+    uint8_t reply[PACKET_MAX_SIZE+PACKET_CRC_SIZE];
+    uint8_t* args = &packet[PACKET_HEADER_SIZE];
+    uint8_t argCount = length - PACKET_HEADER_SIZE;
+    uint8_t opcode = packet[1];
+    uint8_t* out = &reply[3];
+    uint8_t status = STATUS_OK;
+    uint32_t visits[LOGS_PACKET_MAX];
+    uint16_t offset;
+    int i, j;
+
+    reply[0] = packet[0];                       // request id
+    reply[1] = opcode | PACKET_REPLY;
+
+    switch(opcode)
+    {
+    case OP_TIME_SET:
+        if(argCount != 4)
+            status = STATUS_BAD_LENGTH;
+        else
+            setTime(getPacketWord(args));
+        break;
+    case OP_TIME_GET:
+        while(HIB_CTL_WRC & ~HIB_CTL_R);
+        out = putPacketWord(out, HIB_RTCC_R);
+        break;
+    case OP_FEED_ADD:
+        if((argCount != 5 && argCount != 6 && argCount != 10) || args[0] > MAX_SLOT || args[1] > MAX_DURATION
+                || args[2] > MAX_PWM || args[3] > 23 || args[4] > 59
+                || (argCount > 5 && (args[5] == 0 || args[5] > ALL_DAYS)))
+            status = STATUS_BAD_LENGTH;
+        else if(!addFeed(args[0], args[1], args[2], args[3], args[4], argCount > 5 ? args[5] : ALL_DAYS,
+                argCount > 6 ? getPacketHalf(&args[6]) : 0, argCount > 6 ? getPacketHalf(&args[8]) : NO_LAST_DAY))
+            status = STATUS_NO_RANGE;
+        break;
+    case OP_FEED_DELETE:
+        if(argCount != 1 || args[0] > MAX_SLOT)
+            status = STATUS_BAD_LENGTH;
+        else
+            deleteFeed(args[0]);
+        break;
+    case OP_WATER_SET:
+        if(argCount != 2)
+            status = STATUS_BAD_LENGTH;
+        else
+            setVolume(args[0] | (args[1] << 8));
+        break;
+    case OP_WATER_GET:
+        out = putPacketHalf(out, volume);
+        out = putPacketHalf(out, waterLvl);
+        out = putPacketWord(out, Ticks);
+        break;
+    case OP_FILL:
+        if(argCount != 1)
+            status = STATUS_BAD_LENGTH;
+        else
+            setFillMode(args[0] != 0);
+        break;
+    case OP_ALERT:
+        if(argCount != 1)
+            status = STATUS_BAD_LENGTH;
+        else
+            setAlert(args[0] != 0);
+        break;
+    case OP_LOGS:
+        j = argCount == 1 ? args[0] : LOGS_DEFAULT;
+        if(argCount > 1 || j > LOGS_PACKET_MAX)
         {
-            uint32_t hour = getFieldInteger(&data, 1);
-            uint32_t minute = getFieldInteger(&data, 2);
-            uint32_t seconds = hour*3600 + minute*60;
-            HIB_RTCLD_R = seconds;
-            setNextEvent();
-            valid = true;
+            status = STATUS_BAD_LENGTH;
+            break;
         }
-        else if(isCommand(&data, "time", 0))
+        j = readVisits(0, visits, j);
+        out = putPacketHalf(out, getVisitCount());
+        for(i = 0; i < j; i++)
+            out = putPacketWord(out, visits[i]);
+        break;
+    case OP_SCHEDULE:
+        if(argCount > 1)
         {
-            x = HIB_RTCC_R;
-            int hour = x/3600;
-            int minutes = (x%3600)/60;
-            int sec = x-hour*3600-minutes*60;
-            snprintf(str, sizeof(str),"RTC time: %02d:%02d:%02d\n", hour, minutes, sec);
-            putsUart0(str);
-
-            valid = true;
+            status = STATUS_BAD_LENGTH;
+            break;
         }
-        else if(isCommand(&data, "feed", 5))
+        setNextEvent();
+        out = putPacketHalf(out, getFeedCount());
+        i = argCount == 1 ? args[0]*SCHEDULE_PACKET_MAX : 0;
+        for (j = i; j < getFeedCount() && j < i + SCHEDULE_PACKET_MAX; j++)
         {
-            int i, j;
-
-            uint16_t block = getFieldInteger(&data, 1);        // gets the index for new event
-            //  sets eeprom[0] to index, and data to others
-            writeEeprom(16*block+0, block);
-            writeEeprom(16*block+1, getFieldInteger(&data, 2));
-            writeEeprom(16*block+2, getFieldInteger(&data, 3));
-            writeEeprom(16*block+3, getFieldInteger(&data, 4));
-            writeEeprom(16*block+4, getFieldInteger(&data, 5));
-
-            snprintf(str, sizeof(str),"Time: %02d:%02d added to EEprom\n", readEeprom(16*block+3), readEeprom(16*block+4));
-            putsUart0(str);
-            setNextEvent();                             // updates feeding time
-            valid = true;
+            FEED_SLOT feed;
+            getFeedSlot(getFeedByTime(j), &feed);
+            *out++ = feed.flag;
+            *out++ = feed.duration;
+            *out++ = feed.pwm;
+            *out++ = feed.hour;
+            *out++ = feed.minute;
+            *out++ = feed.days;
+            out = putPacketHalf(out, feed.firstDay);
+            out = putPacketHalf(out, feed.lastDay);
         }
-        else if(isCommand(&data, "feed", 2))
+        while(HIB_CTL_WRC & ~HIB_CTL_R);
+        out = putPacketWord(out, HIB_RTCM0_R);
+        break;
+    case OP_CONFIG_DUMP:
+        if(argCount != 2)
         {
-            uint16_t block = getFieldInteger(&data, 1);
-            snprintf(str, sizeof(str),"Time: %02d:%02d deleted\n", readEeprom(16*block+3), readEeprom(16*block+4));
-            putsUart0(str);
-            // places 11 for unavaliable index and 0 for data
-            writeEeprom(16*block+0, 11);
-            writeEeprom(16*block+1, 0);
-            writeEeprom(16*block+2, 0);
-            writeEeprom(16*block+3, 0);
-            writeEeprom(16*block+4, 0);
-            setNextEvent();                             // recalibrates next feeding time
-
-            valid = true;
+            status = STATUS_BAD_LENGTH;
+            break;
         }
-        else if(isCommand(&data, "water", 1))
+        offset = getPacketHalf(args);
+        snapshotLength = 0;                     // the dump shares the buffer, a load in progress starts over
+        j = exportSnapshot(snapshot);
+        out = putPacketHalf(out, j);
+        for(i = offset; i < j && i < offset + CONFIG_PACKET_MAX; i++)
+            out = putPacketWord(out, snapshot[i]);
+        break;
+    case OP_CONFIG_LOAD:
+        if(argCount < 2 || (argCount - 2) % 4 != 0)
         {
-            volume = getFieldInteger(&data, 1);
-            writeEeprom(5, volume);
-            valid = 1;
+            status = STATUS_BAD_LENGTH;
+            break;
         }
-        else if(isCommand(&data, "water", 0))
+        i = receiveSnapshot(getPacketHalf(args), &args[2], (argCount - 2)/4);
+        if(i == CONFIG_INVALID)
+            status = STATUS_BAD_CONFIG;
+        else
+            *out++ = i == CONFIG_LOADED;
+        break;
+    case OP_CATCHUP:
+        if(argCount > 1 || (argCount == 1 && args[0] > CATCHUP_SKIP))
         {
-            snprintf(str, sizeof(str),"Refill level: %d\tWater level: %d mL\tTicks: %d\n", volume, waterLvl, Ticks);
-            putsUart0(str);
-            valid = 1;
+            status = STATUS_BAD_LENGTH;
+            break;
         }
-        else if(isCommand(&data, "fill", 1))
+        if(argCount == 1)
+            setCatchUpPolicy(args[0]);
+        *out++ = getCatchUpPolicy();
+        out = putPacketWord(out, getLastFeedTime());
+        out = putPacketHalf(out, getMissedFeeds());
+        break;
+    case OP_TEXT:
+        binaryMode = false;
+        setUart0FlowControl(textFlowControl);
+        break;
+    default:
+        status = STATUS_BAD_OPCODE;
+        break;
+    }
+    if(status != STATUS_OK)
+        out = &reply[3];
+    reply[2] = status;
+
+    while(reportBusy);                          // report buffer carries the encoded frame
+    sendReport(encodePacket(reply, out - reply, (uint8_t*)report));
+}
+
+// collects binary frames from the uart0 rx ring, runs each complete one, returns once the ring is empty
+void getPacketsUart0()
+{
+    uint8_t packet[FRAME_MAX_SIZE];
+    uint16_t length;
+
+    while(binaryMode && kbhitUart0())
+    {
+        length = receiveFrameByte(&frameRx, getcUart0(), packet);
+        if(length)
+            processPacket(packet, length);
+    }
+}
+
+// Shell command handlers, arguments are already checked against the command table
+
+// time HH:MM → keeps the date
+void timeSetCommand(USER_DATA* data)
+{
+    while(HIB_CTL_WRC & ~HIB_CTL_R);
+    setTime(HIB_RTCC_R/SECONDS_PER_DAY*SECONDS_PER_DAY + getFieldTime(data, 1));
+}
+
+// date YYYY-MM-DD → keeps the time of day
+void dateSetCommand(USER_DATA* data)
+{
+    while(HIB_CTL_WRC & ~HIB_CTL_R);
+    setTime(getFieldDate(data, 1)*SECONDS_PER_DAY + HIB_RTCC_R%SECONDS_PER_DAY);
+}
+
+// prints RTC seconds as "YYYY-MM-DD Ddd HH:MM" followed by end
+void putDateTimeUart0(uint32_t seconds, bool showSeconds, const char* end)
+{
+    char line[32];
+    char* out = formatDate(line, seconds/SECONDS_PER_DAY);
+    *out++ = ' ';
+    out = formatTime(out, seconds%SECONDS_PER_DAY, showSeconds);
+    out = formatString(out, end);
+    *out = 0;
+    putsUart0(line);
+}
+
+void timeCommand(USER_DATA* data)
+{
+    uint32_t x = HIB_RTCC_R;
+    putsUart0("RTC time: ");
+    putDateTimeUart0(x, true, "\n");
+}
+
+// weekday mask of a field checked as 'w': daily, weekdays, weekends, or ISO day digits (1 Monday to
+//  7 Sunday), "67" is Saturday and Sunday
+uint8_t getFieldWeekdays(USER_DATA* data, uint8_t fieldNumber)
+{
+    uint8_t keyword = getFieldKeyword(data, fieldNumber);
+    uint32_t digits = getFieldInteger(data, fieldNumber);
+    uint8_t mask = 0;
+    if(keyword == KEYWORD_DAILY)
+        return ALL_DAYS;
+    if(keyword == KEYWORD_WEEKDAYS)
+        return WEEKDAYS;
+    if(keyword == KEYWORD_WEEKENDS)
+        return WEEKEND_DAYS;
+    for(; digits != 0; digits /= 10)
+    {
+        if(digits % 10 == 0 || digits % 10 > 7)
+            return 0;
+        mask |= 1 << (digits % 10 % 7);
+    }
+    return mask;
+}
+
+// feed <index> <duration> <pwm> <HH:MM> [<weekdays> [<first date> [<last date>]]]
+void feedAddCommand(USER_DATA* data)
+{
+    uint16_t block = getFieldInteger(data, 1);        // gets the index for new event
+    uint32_t seconds = getFieldTime(data, 4);
+    uint8_t days = data->fieldCount > 5 ? getFieldWeekdays(data, 5) : ALL_DAYS;
+    uint32_t firstDay = data->fieldCount > 6 ? getFieldDate(data, 6) : 0;
+    uint32_t lastDay = data->fieldCount > 7 ? getFieldDate(data, 7) : NO_LAST_DAY;
+    FEED_SLOT feed;
+    if(!addFeed(block, getFieldInteger(data, 2), getFieldInteger(data, 3), seconds/3600, (seconds%3600)/60,
+            days, firstDay, lastDay))
+    {
+        putsUart0(firstDay > lastDay ? "Last date is before the first\n" : "Date range table full\n");
+        return;
+    }
+
+    getFeedSlot(block, &feed);
+    putsUart0("Time: ");
+    putuUart0(feed.hour, 2);
+    putcUart0(':');
+    putuUart0(feed.minute, 2);
+    putsUart0(" added to EEprom\n");
+}
+
+void feedDeleteCommand(USER_DATA* data)
+{
+    uint16_t block = getFieldInteger(data, 1);
+    FEED_SLOT feed;
+    getFeedSlot(block, &feed);
+    putsUart0("Time: ");
+    putuUart0(feed.hour, 2);
+    putcUart0(':');
+    putuUart0(feed.minute, 2);
+    putsUart0(" deleted\n");
+    deleteFeed(block);
+}
+
+void waterSetCommand(USER_DATA* data)
+{
+    setVolume(getFieldInteger(data, 1));
+}
+
+void waterCommand(USER_DATA* data)
+{
+    putsUart0("Refill level: ");
+    putuUart0(volume, 1);
+    putsUart0("\tWater level: ");
+    putuUart0(waterLvl, 1);
+    putsUart0(" mL\tTicks: ");
+    putuUart0(Ticks, 1);
+    putcUart0('\n');
+}
+
+// fill auto | fill motion
+void fillCommand(USER_DATA* data)
+{
+    setFillMode(getFieldKeyword(data, 1) == KEYWORD_AUTO);
+}
+
+void setCommand(USER_DATA* data)
+{
+}
+
+// alert ON|OFF → alert ON or alert OFF are the expected commands
+void alertCommand(USER_DATA* data)
+{
+    setAlert(getFieldKeyword(data, 1) == KEYWORD_ON);
+}
+
+// catchup → policy, last feeding run and the feedings missed at the last check
+void catchupCommand(USER_DATA* data)
+{
+    static char* names[] = {"run", "merge", "skip"};
+    putsUart0("catchup ");
+    putsUart0(names[getCatchUpPolicy()]);
+    putsUart0("\tlast feeding: ");
+    if(getLastFeedTime() == NO_FEED_TIME)
+        putsUart0("none\n");
+    else
+        putDateTimeUart0(getLastFeedTime(), false, "\n");
+    putsUart0("missed at last check: ");
+    putuUart0(getMissedFeeds(), 1);
+    putcUart0('\n');
+}
+
+// catchup run|merge|skip → what to do with feedings missed while off or skipped by a clock change
+void catchupSetCommand(USER_DATA* data)
+{
+    uint8_t keyword = getFieldKeyword(data, 1);
+    setCatchUpPolicy(keyword == KEYWORD_RUN ? CATCHUP_RUN : keyword == KEYWORD_MERGE ? CATCHUP_MERGE : CATCHUP_SKIP);
+}
+
+// logs [count] → newest visits first
+void logsCommand(USER_DATA* data)
+{
+    uint32_t visits[LOGS_CHUNK];
+    uint32_t count = data->fieldCount > 1 ? getFieldInteger(data, 1) : LOGS_DEFAULT;
+    uint16_t j, n = 0, age = 0;
+    putuUart0(getVisitCount(), 1);
+    putsUart0(" visits stored\n");
+    for(j = 0; age < count; j++){
+        if(j == n){                     // next chunk, one EEPROM burst per block
+            n = readVisits(age, visits, count - age < LOGS_CHUNK ? count - age : LOGS_CHUNK);
+            j = 0;
+            if(n == 0)
+                break;
+        }
+        age++;
+        putDateTimeUart0(visits[j], false, "\n");
+    }
+}
+
+// schedule [page] → feedings in time order, SCHEDULE_PAGE per page starting at page 1, then the next alarm
+void scheduleCommand(USER_DATA* data)
+{
+    uint16_t count = getFeedCount();
+    uint16_t pages = count == 0 ? 1 : (count + SCHEDULE_PAGE - 1)/SCHEDULE_PAGE;
+    uint16_t page = data->fieldCount > 1 ? getFieldInteger(data, 1) : 1;
+    char* out = report;
+    int i;
+
+    if(page == 0)
+    {
+        page = 1;
+    }
+    setNextEvent();
+    while(reportBusy);                          // previous report may still be going out
+    out = formatUnsigned(out, count, 1);
+    out = formatString(out, " feedings, page ");
+    out = formatUnsigned(out, page, 1);
+    out = formatString(out, " of ");
+    out = formatUnsigned(out, pages, 1);
+    *out++ = '\n';
+    for (i = (page-1)*SCHEDULE_PAGE; i < count && i < page*SCHEDULE_PAGE; i++){
+        FEED_SLOT feed;
+        getFeedSlot(getFeedByTime(i), &feed);
+        out = formatUnsigned(out, feed.flag, 1);
+        *out++ = '\t';
+        out = formatUnsigned(out, feed.duration, 1);
+        *out++ = '\t';
+        out = formatUnsigned(out, feed.pwm, 1);
+        *out++ = '\t';
+        out = formatUnsigned(out, feed.hour, 2);
+        *out++ = ':';
+        out = formatUnsigned(out, feed.minute, 2);
+        *out++ = '\t';
+        out = formatWeekdays(out, feed.days);
+        if(feed.firstDay != 0 || feed.lastDay != NO_LAST_DAY)
         {
-            char* cmd = getFieldString(&data, 1);
-            if(cmd[0] == 'a')
-            {
-                modeSet = 1;
-            }
-            else if(cmd[0] == 'm')
-            {
-                modeSet = 0;
-            }
-            writeEeprom(6, modeSet);
-            valid = 1;
+            *out++ = '\t';
+            if(feed.firstDay != 0)
+                out = formatDate(out, feed.firstDay);
+            out = formatString(out, " to ");
+            if(feed.lastDay != NO_LAST_DAY)
+                out = formatDate(out, feed.lastDay);
+        }
+        *out++ = '\n';
+    }
+    while(HIB_CTL_WRC & ~HIB_CTL_R);
+    uint32_t c = HIB_RTCM0_R;
+    if(nextEventIndex < 0)
+    {
+        out = formatString(out, "nothing left to feed");
+    }
+    else
+    {
+        out = formatString(out, "next: ");
+        out = formatDate(out, c/SECONDS_PER_DAY);
+        *out++ = ' ';
+        out = formatTime(out, c%SECONDS_PER_DAY, false);
+    }
+    *out++ = '\n';
+    sendReport(out - report);
+}
+
+void baudSetCommand(USER_DATA* data)
+{
+    negotiateBaudRate(data, getFieldInteger(data, 1));
+}
+
+void baudCommand(USER_DATA* data)
+{
+    putsUart0("baud ");
+    putuUart0(getUart0BaudRate(), 1);
+    putcUart0('\n');
+}
+
+void binaryCommand(USER_DATA* data)
+{
+    putsUart0("binary mode\n");
+    frameRx.count = 0;
+    binaryMode = true;
+    textFlowControl = getUart0FlowControl();
+    setUart0FlowControl(false);                 // frames may contain XON/XOFF bytes
+}
+
+// flow on | flow off
+void flowCommand(USER_DATA* data)
+{
+    setUart0FlowControl(getFieldKeyword(data, 1) == KEYWORD_ON);
+}
+
+void uartCommand(USER_DATA* data)
+{
+    UART0_STATS stats;
+    getUart0Stats(&stats);
+    putsUart0("overrun: ");
+    putuUart0(stats.overrun, 1);
+    putsUart0("\tframing: ");
+    putuUart0(stats.framing, 1);
+    putsUart0("\tparity: ");
+    putuUart0(stats.parity, 1);
+    putsUart0("\tbreak: ");
+    putuUart0(stats.breaks, 1);
+    putsUart0("\tdropped: ");
+    putuUart0(stats.dropped, 1);
+    putsUart0("\txoff: ");
+    putuUart0(stats.xoff, 1);
+    putsUart0(getUart0FlowControl() ? "\tflow on\n" : "\tflow off\n");
+}
+
+// config dump → prints the "config load" lines that restore the schedule and settings on any feeder
+void configDumpCommand(USER_DATA* data)
+{
+    uint8_t bytes[CONFIG_LINE_WORDS*4];
+    uint16_t length, count;
+    int i, j;
+
+    snapshotLength = 0;                         // the dump shares the buffer, a load in progress starts over
+    length = exportSnapshot(snapshot);
+    for(i = 0; i < length; i += CONFIG_LINE_WORDS)
+    {
+        char* out = report;
+        count = length - i < CONFIG_LINE_WORDS ? length - i : CONFIG_LINE_WORDS;
+        for(j = 0; j < count; j++)
+            putPacketWord(&bytes[4*j], snapshot[i+j]);
+        while(reportBusy);
+        out = formatString(out, "config load ");
+        out = formatUnsigned(out, i, 1);
+        *out++ = ' ';
+        out = formatHexBytes(out, bytes, count*4);
+        *out++ = '\n';
+        sendReport(out - report);
+    }
+}
+
+// config load <offset> <hex> → one line printed by config dump, the snapshot is loaded after its last line
+void configLoadCommand(USER_DATA* data)
+{
+    const char* hex = &data->buffer[data->fieldPosition[3]];
+    uint8_t bytes[CONFIG_LINE_WORDS*4];
+    uint8_t result;
+    int i;
+
+    for(i = 0; i < CONFIG_LINE_WORDS*8; i++)
+    {
+        char c = hex[i] | 0x20;                 // lower case, a null becomes a space
+        uint8_t nibble = c >= '0' && c <= '9' ? c - '0' : c >= 'a' && c <= 'f' ? c - 'a' + 10 : 16;
+        if(nibble == 16)
+        {
+            break;
         }
-        else if(isCommand(&data, "set", 2))
+        bytes[i/2] = (i & 1) ? bytes[i/2] << 4 | nibble : nibble;
+    }
+    if(i == 0 || i % 8 != 0 || hex[i] != 0)
+    {
+        snapshotLength = 0;
+        putsUart0("config invalid\n");
+        return;
+    }
+    result = receiveSnapshot(getFieldInteger(data, 2), bytes, i/8);
+    if(result == CONFIG_LOADED)
+        putsUart0("config loaded\n");
+    else if(result == CONFIG_INVALID)
+        putsUart0("config invalid\n");
+}
+
+void perfCommand(USER_DATA* data)
+{
+    uint32_t performed, skipped, wakeups, callbacks;
+    putsUart0("uart tx ring: ");
+    putuUart0(getUart0RingCyclesPerByte(), 1);
+    putsUart0(" cycles/byte\tuart tx dma: ");
+    putuUart0(getUart0DmaCyclesPerByte(), 1);
+    putsUart0(" cycles/byte\n");
+    putsUart0("setNextEvent: ");
+    putuUart0(nextEventCycles, 1);
+    putsUart0(" cycles, max ");
+    putuUart0(maxNextEventCycles, 1);
+    putsUart0(" cycles\n");
+    putsUart0("log isr: max ");
+    putuUart0(maxLogIsrCycles, 1);
+    putsUart0(" cycles\teeprom queue dropped: ");
+    putuUart0(getEepromQueueDropped(), 1);
+    putcUart0('\n');
+    getEepromWriteCounts(&performed, &skipped);
+    putsUart0("eeprom words programmed: ");
+    putuUart0(performed, 1);
+    putsUart0("\tskipped unchanged: ");
+    putuUart0(skipped, 1);
+    putcUart0('\n');
+    putsUart0("boot eeprom check: ");
+    putuUart0(validateCycles, 1);
+    putsUart0(" cycles\n");
+    getTimerCounts(&wakeups, &callbacks);
+    putsUart0("timer interrupts: ");
+    putuUart0(wakeups, 1);
+    putsUart0("\ttimer callbacks: ");
+    putuUart0(callbacks, 1);
+    putcUart0('\n');
+}
+
+// Shell command table, one entry per name and argument count
+//  argument types: 'n' number, 's' feed slot index (0-255), 'u' feed duration (0-63 s), 'p' pwm (0-100),
+//      't' time of day HH:MM, 'y' date YYYY-MM-DD, 'a' word,
+//      'h' run of letters and digits (checked by the handler),
+//      'w' weekdays, daily|weekdays|weekends or ISO day digits 1-7 (see getFieldWeekdays),
+//      keywords: 'd' delete, 'f' auto|motion, 'o' on|off, 'c' dump, 'l' load, 'k' run|merge|skip
+//  entries sharing a name must have argument count ranges that do not overlap
+const COMMAND commands[] =
+{
+    {"time",     0, 0, "",        timeCommand},
+    {"time",     1, 1, "t",       timeSetCommand},
+    {"date",     1, 1, "y",       dateSetCommand},
+    {"feed",     4, 7, "suptwyy", feedAddCommand},
+    {"feed",     2, 2, "sd",      feedDeleteCommand},
+    {"water",    0, 0, "",        waterCommand},
+    {"water",    1, 1, "n",       waterSetCommand},
+    {"fill",     1, 1, "f",       fillCommand},
+    {"set",      2, 2, "nn",      setCommand},
+    {"alert",    1, 1, "o",       alertCommand},
+    {"logs",     0, 1, "n",       logsCommand},
+    {"schedule", 0, 1, "n",       scheduleCommand},
+    {"baud",     0, 0, "",        baudCommand},
+    {"baud",     1, 1, "n",       baudSetCommand},
+    {"binary",   0, 0, "",        binaryCommand},
+    {"flow",     1, 1, "o",       flowCommand},
+    {"uart",     0, 0, "",        uartCommand},
+    {"perf",     0, 0, "",        perfCommand},
+    {"catchup",  0, 0, "",        catchupCommand},
+    {"catchup",  1, 1, "k",       catchupSetCommand},
+    {"config",   1, 1, "c",       configDumpCommand},
+    {"config",   3, 3, "lnh",     configLoadCommand},
+};
+#define COMMAND_COUNT (sizeof(commands)/sizeof(commands[0]))
+
+// commands[] indexes grouped by name length, filled once by initCommands()
+uint8_t commandBucketStart[MAX_COMMAND_LENGTH+2];
+uint8_t commandBucket[COMMAND_COUNT];
+
+// groups the command table by name length so lookups only compare names of the right length
+void initCommands()
+{
+    uint8_t count[MAX_COMMAND_LENGTH+1] = {0};
+    uint8_t length;
+    int i;
+
+    for(i = 0; i < COMMAND_COUNT; i++)
+    {
+        for(length = 0; commands[i].name[length]; length++);
+        count[length]++;
+    }
+    commandBucketStart[0] = 0;
+    for(length = 0; length <= MAX_COMMAND_LENGTH; length++)
+    {
+        commandBucketStart[length+1] = commandBucketStart[length] + count[length];
+        count[length] = commandBucketStart[length];     // reused as the fill position
+    }
+    for(i = 0; i < COMMAND_COUNT; i++)
+    {
+        for(length = 0; commands[i].name[length]; length++);
+        commandBucket[count[length]++] = i;
+    }
+}
+
+// finds the table entry whose name matches field 0 exactly and accepts the argument count
+//  returns 0 if there is none
+const COMMAND* findCommand(USER_DATA* data)
+{
+    char* name = getFieldString(data, 0);
+    uint8_t argCount = data->fieldCount - 1;
+    uint8_t length;
+    int i, j;
+
+    if(!name)
+    {
+        return 0;
+    }
+    for(length = 0; name[length]; length++)
+    {
+        if(length == MAX_COMMAND_LENGTH)
         {
-            int32_t add = getFieldInteger(&data, 1);
-            int32_t dataS = getFieldInteger(&data, 2);
-            valid = true;
+            return 0;
         }
-        // alert ON|OFF → alert ON or alert OFF are the expected commands
-        else if (isCommand(&data,"alert", 1))
+    }
+    for(i = commandBucketStart[length]; i < commandBucketStart[length+1]; i++)
+    {
+        const COMMAND* command = &commands[commandBucket[i]];
+        for(j = 0; j < length && command->name[j] == name[j]; j++);
+        if(j == length && argCount >= command->minArgs && argCount <= command->maxArgs)
         {
-            char* str = getFieldString(&data, 1);
-            if(str[1] == 'N' || str[1] == 'n')
-            {
-                alert = 1;
-            }
-            else if(str[1]  == 'F' || str[1] == 'f')
-            {
-                alert = 0;
-            }
-            writeEeprom(7, alert);
-            valid = true;
-            // process the string with your custom strcmp instruction, then do something
+            return command;
         }
-        else if(isCommand(&data,"logs", 0)){
-            int j;
-                for(j = 6; j<12; j++){
-                    uint32_t y = readEeprom(16*1+j);
-                    int hour = y/3600;
-                    int minutes = (y%3600)/60;
-                    snprintf(str, sizeof(str),"%d:%d", hour, minutes);
-                    putsUart0(str);
-                    putsUart0("\n");
-                }
-                valid =1;
+    }
+    return 0;
+}
+
+// checks every argument against the type the command table expects
+bool checkArguments(USER_DATA* data, const COMMAND* command)
+{
+    int i;
+    for(i = 1; i < data->fieldCount; i++)
+    {
+        char type = command->argTypes[i-1];
+        char field = data->fieldType[i];
+        uint32_t value = data->fieldValue[i];
+        bool ok;
+        switch(type)
+        {
+        case 'n':
+            ok = field == 'n';
+            break;
+        case 's':
+            ok = field == 'n' && value <= MAX_SLOT;
+            break;
+        case 'u':
+            ok = field == 'n' && value <= MAX_DURATION;
+            break;
+        case 'p':
+            ok = field == 'n' && value <= MAX_PWM;
+            break;
+        case 't':
+            ok = field == 't';
+            break;
+        case 'a':
+            ok = field == 'a';
+            break;
+        case 'd':
+            ok = field == 'a' && value == KEYWORD_DELETE;
+            break;
+        case 'f':
+            ok = field == 'a' && (value == KEYWORD_AUTO || value == KEYWORD_MOTION);
+            break;
+        case 'o':
+            ok = field == 'a' && (value == KEYWORD_ON || value == KEYWORD_OFF);
+            break;
+        case 'w':
+            ok = getFieldWeekdays(data, i) != 0;
+            break;
+        case 'k':
+            ok = field == 'a' && (value == KEYWORD_RUN || value == KEYWORD_MERGE || value == KEYWORD_SKIP);
+            break;
+        case 'y':
+            ok = field == 'y';
+            break;
+        case 'h':
+            ok = field == 'a' || field == 'n' || field == 'x';
+            break;
+        case 'c':
+            ok = field == 'a' && value == KEYWORD_DUMP;
+            break;
+        case 'l':
+            ok = field == 'a' && value == KEYWORD_LOAD;
+            break;
+        default:
+            ok = false;
+            break;
         }
-        else if(isCommand(&data,"schedule", 0)){
-            int i,j;
-
-            setNextEvent();
-            for (i = 0; i < 10; i++){
-                for(j = 0; j<5; j++){
-                    uint32_t values = readEeprom(16*i+j);
-                    snprintf(str, sizeof(str),"%d\t", values);
-                    putsUart0(str);
-                }
-                putsUart0("\n");
-            }
-            while(HIB_CTL_WRC & ~HIB_CTL_R);
-            uint32_t c = HIB_RTCM0_R;
-            snprintf(str, sizeof(str),"%02d:%02d\n", c/3600, (c%3600)/60);
-            putsUart0(str);
-            valid = 1;
+        if(!ok)
+        {
+            return false;
         }
+    }
+    return true;
+}
 
-        // Look for invalid command
-        if (!valid)
+// runs one parsed command, returns false if it is not a valid command
+bool processCommand(USER_DATA* data)
+{
+    const COMMAND* command = findCommand(data);
+    if(!command || !checkArguments(data, command))
+    {
+        return false;
+    }
+    command->handler(data);
+    return true;
+}
+
+// runs every ';' separated command of a line as one batch, the next feeding is recomputed
+//  once at the end instead of after every feed or time command, and the feedings it changed
+//  are programmed into EEPROM together
+void processLine(USER_DATA* data)
+{
+    USER_DATA command;
+    char* start = data->buffer;
+    int i;
+
+    deferSchedule = true;
+    deferFeedWrites();
+    while(true)
+    {
+        for(i = 0; start[i] && start[i] != ';'; i++)
+        {
+            command.buffer[i] = start[i];
+        }
+        command.buffer[i] = 0;
+        command.charCount = 0;
+        parseFields(&command);
+        if(command.fieldCount && !processCommand(&command))     // empty commands are skipped
         {
             putsUart0("Invalid command\n");
         }
+        if(!start[i])
+        {
+            break;
+        }
+        start = &start[i+1];
+    }
+    deferSchedule = false;
+    commitFeedWrites();
+    if(scheduleDirty)
+    {
+        setNextEvent();
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Main
+//-----------------------------------------------------------------------------
+// Controls all input command and initialization
+int main(void)
+{
+    // Initialize hardware
+    initHw();
+    initUart0();
+    initLayout();
+    uint32_t start = readCycleCounter();
+    uint8_t restored = validateLayout();
+    validateCycles = readCycleCounter() - start;
+    if(restored & (1 << REGION_CONFIG))
+        putsUart0("EEPROM config invalid, defaults restored\n");
+    if(restored & (1 << REGION_SCHEDULE))
+        putsUart0("EEPROM schedule invalid, cleared\n");
+    if(restored & (1 << REGION_RANGES))
+        putsUart0("EEPROM date ranges invalid, cleared\n");
+    loadSchedule();
+    initVisitLog();
+    USER_DATA data;
+    data.charCount = 0;
+    initCommands();
+    init10secWater();
+    init2secMotion();
+    init3seclog();
+    loadConfig();
+    loadCatchUp(startFeeding);
+    while(HIB_CTL_WRC & ~HIB_CTL_R);
+    catchUpFeeds(HIB_RTCC_R);                   // feedings missed while the power was off
+    setNextEvent();
+    while(true)
+    {
+        drainEepromQueue();
+        if(binaryMode)
+        {
+            getPacketsUart0();
+            continue;
+        }
+        if(!getsUart0NonBlocking(&data))    //  Get the string from the user without stalling the loop
+        {
+            continue;
+        }
+        processLine(&data);
     }
 }
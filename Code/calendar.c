@@ -0,0 +1,80 @@
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target uC:       TM4C123GH6PM
+// System Clock:    -
+
+// Gregorian calendar arithmetic on day numbers, days since 1970-01-01, so the RTC seconds divided by
+//   SECONDS_PER_DAY give the date without any search
+//   conversions count in 400 year eras starting on March 1st, which puts the leap day last
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "calendar.h"
+
+#define DAYS_PER_ERA    146097      // 400 years
+#define EPOCH_SHIFT     719468      // days from 0000-03-01 to 1970-01-01
+#define EPOCH_WEEKDAY   4           // 1970-01-01 was a Thursday
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+// Day number of a date, the date must be valid and not before FIRST_YEAR
+uint32_t daysFromCivil(uint32_t year, uint32_t month, uint32_t day)
+{
+    uint32_t era, yearOfEra, dayOfYear;
+    if (month <= 2)
+        year--;
+    era = year / 400;
+    yearOfEra = year - era * 400;
+    dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    return era * DAYS_PER_ERA + yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear - EPOCH_SHIFT;
+}
+
+void civilFromDays(uint32_t days, uint32_t* year, uint32_t* month, uint32_t* day)
+{
+    uint32_t shifted = days + EPOCH_SHIFT;
+    uint32_t era = shifted / DAYS_PER_ERA;
+    uint32_t dayOfEra = shifted - era * DAYS_PER_ERA;
+    uint32_t yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    uint32_t dayOfYear = dayOfEra - (yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100);
+    uint32_t monthIndex = (5 * dayOfYear + 2) / 153;    // 0 is March
+    *day = dayOfYear - (153 * monthIndex + 2) / 5 + 1;
+    *month = monthIndex < 10 ? monthIndex + 3 : monthIndex - 9;
+    *year = era * 400 + yearOfEra + (*month <= 2);
+}
+
+uint8_t getMonthDays(uint32_t year, uint32_t month)
+{
+    if (month == 2)
+        return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0 ? 29 : 28;
+    return month == 4 || month == 6 || month == 9 || month == 11 ? 30 : 31;
+}
+
+// 0 Sunday to 6 Saturday
+uint8_t getWeekday(uint32_t days)
+{
+    return (days + EPOCH_WEEKDAY) % 7;
+}
+
+// Days from weekday to the first day in mask, 0 when weekday itself is in it, 7 when mask is empty
+//  the mask is rotated so weekday is bit 0, then the lowest set bit is the answer
+uint8_t getDaysUntil(uint8_t mask, uint8_t weekday)
+{
+    uint16_t rotated = ((mask | (mask << 7)) >> weekday) & ALL_DAYS;
+    uint8_t days = 0;
+    if (rotated == 0)
+        return 7;
+    while (!(rotated & 1))
+    {
+        rotated >>= 1;
+        days++;
+    }
+    return days;
+}
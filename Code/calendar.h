@@ -0,0 +1,35 @@
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target uC:       TM4C123GH6PM
+// System Clock:    -
+
+#ifndef CALENDAR_H_
+#define CALENDAR_H_
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#define SECONDS_PER_DAY 86400
+#define FIRST_YEAR      1970        // RTC second 0 is 1970-01-01 00:00
+#define LAST_YEAR       2105        // last full year a 32 bit RTC reaches
+#define LAST_DAY        49672       // day number of LAST_YEAR-12-31
+
+// Weekday masks, bit 0 is Sunday as returned by getWeekday()
+#define ALL_DAYS        0x7F
+#define WEEKDAYS        0x3E
+#define WEEKEND_DAYS    0x41
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+uint32_t daysFromCivil(uint32_t year, uint32_t month, uint32_t day);
+void civilFromDays(uint32_t days, uint32_t* year, uint32_t* month, uint32_t* day);
+uint8_t getMonthDays(uint32_t year, uint32_t month);
+uint8_t getWeekday(uint32_t days);
+uint8_t getDaysUntil(uint8_t mask, uint8_t weekday);
+
+#endif
@@ -0,0 +1,236 @@
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target uC:       TM4C123GH6PM
+// System Clock:    -
+
+// Feedings due to run: the ones at an alarm's time and the ones missed while the power was off or the
+//   clock was set forward
+//   the feedings after (dueTime, dueSlot) in time and slot order and up to dueUntil are run one after
+//   the other, each started when the one before ends, so feedings sharing a time all run
+//   the time of the last feeding run is kept in EE_LAST_FEED, on boot and when the clock is set the
+//   feedings after it are found in a single pass and handled by the catch-up policy in EE_CATCHUP
+//
+// The cursor and the merged run waiting are changed by the hibernate isr (runAlarmFeeds), the auger
+//   timer isr (endFeeding) and the main loop (catchUpFeeds), each change and the auger start it decides
+//   are made with interrupts disabled
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "tm4c123gh6pm.h"
+#include "eeprom.h"
+#include "calendar.h"
+#include "layout.h"
+#include "schedule.h"
+#include "catchup.h"
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+FEEDING_CALLBACK startAuger;
+uint32_t lastFeedTime = NO_FEED_TIME;   // RTC seconds of the last feeding run, kept in EE_LAST_FEED
+uint8_t catchupPolicy = CATCHUP_MERGE;
+uint16_t missedFeeds = 0;           // feedings found missed by the last catch-up check
+volatile uint32_t dueTime = 0;
+volatile int16_t dueSlot = FEED_CURSOR_END;
+volatile uint32_t dueUntil = 0;
+volatile bool feeding = false;      // the auger is running a feeding
+volatile uint32_t mergedDuration = 0;    // merged run waiting for the feeding running to end, 0 for none
+volatile uint32_t mergedPwm = 0;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+// Reads the last feeding run and the catch-up policy, start runs the auger, call once at boot after
+//  loadSchedule()
+void loadCatchUp(FEEDING_CALLBACK start)
+{
+    startAuger = start;
+    feeding = false;
+    dueTime = 0;
+    dueSlot = FEED_CURSOR_END;
+    dueUntil = 0;
+    mergedDuration = 0;
+    lastFeedTime = readEeprom(EE_LAST_FEED);
+    catchupPolicy = readEeprom(EE_CATCHUP);
+    if (catchupPolicy > CATCHUP_SKIP)
+        catchupPolicy = CATCHUP_MERGE;
+}
+
+void setCatchUpPolicy(uint8_t policy)
+{
+    catchupPolicy = policy;
+    writeEeprom(EE_CATCHUP, policy);
+}
+
+uint8_t getCatchUpPolicy(void)
+{
+    return catchupPolicy;
+}
+
+uint32_t getLastFeedTime(void)
+{
+    return lastFeedTime;
+}
+
+uint16_t getMissedFeeds(void)
+{
+    return missedFeeds;
+}
+
+// Notes the time of the feeding just run, the EEPROM write is queued so this is safe in an isr
+void recordFeedTime(uint32_t seconds)
+{
+    lastFeedTime = seconds;
+    queueEepromWrite(EE_LAST_FEED, seconds);
+}
+
+// Starts the auger, the feedings still due wait for endFeeding()
+void runFeeding(uint32_t duration, uint32_t pwm)
+{
+    feeding = true;
+    startAuger(duration, pwm);
+}
+
+// Starts the next feeding after (dueTime, dueSlot) due by dueUntil, call with interrupts disabled
+void runNextDue(void)
+{
+    FEED_SLOT feed;
+    uint32_t when;
+    int16_t slot;
+    if (dueTime >= dueUntil && dueSlot == FEED_CURSOR_END)
+        return;
+    slot = findNextFeed(dueTime, dueSlot, &when);
+    if (slot < 0 || when > dueUntil)
+    {
+        dueTime = dueUntil;
+        dueSlot = FEED_CURSOR_END;
+        return;
+    }
+    dueTime = when;
+    dueSlot = slot;
+    getFeedSlot(slot, &feed);
+    runFeeding(feed.duration, feed.pwm);
+}
+
+// Runs every feeding at the alarm's time (RTC seconds) one after the other, after any still running or
+//  due, called from the hibernate isr
+//  with none left due the cursor starts over at the alarm, it may be behind feedings run before the
+//  clock was set back
+void runAlarmFeeds(uint32_t alarm)
+{
+    uint32_t state = _disable_interrupts();
+    if (!feeding || (dueTime >= dueUntil && dueSlot == FEED_CURSOR_END))
+    {
+        dueTime = alarm;
+        dueSlot = FEED_CURSOR_START;
+    }
+    dueUntil = alarm;
+    if (!feeding)
+        runNextDue();
+    _restore_interrupts(state);
+    recordFeedTime(alarm);
+}
+
+// Makes the missed feedings after from and up to until due, after the ones still due from before from
+//  unless they are older than from, and starts the first when the auger is idle
+void addMissedFeeds(uint32_t from, uint32_t until)
+{
+    uint32_t state = _disable_interrupts();
+    if (!feeding || dueTime < from)
+    {
+        dueTime = from;
+        dueSlot = FEED_CURSOR_END;
+    }
+    dueUntil = until;
+    if (!feeding)
+        runNextDue();
+    _restore_interrupts(state);
+}
+
+// Drops the feedings still due, up to until or all of them, the one running ends as it would
+void dropDueFeeds(uint32_t until, bool all)
+{
+    uint32_t state = _disable_interrupts();
+    if (all || until < dueUntil)
+    {
+        dueTime = until;
+        dueSlot = FEED_CURSOR_END;
+        dueUntil = until;
+    }
+    _restore_interrupts(state);
+}
+
+// Drops the feedings still due and runs one feeding of duration seconds at pwm, at once when the auger
+//  is idle, otherwise after the feeding running, added to a merged run already waiting
+void runMergedFeeding(uint32_t until, uint32_t duration, uint32_t pwm)
+{
+    uint32_t state = _disable_interrupts();
+    dueTime = until;
+    dueSlot = FEED_CURSOR_END;
+    dueUntil = until;
+    if (feeding)
+    {
+        duration += mergedDuration;
+        mergedDuration = duration > MAX_DURATION ? MAX_DURATION : duration;
+        mergedPwm = pwm;
+    }
+    else
+        runFeeding(duration, pwm);
+    _restore_interrupts(state);
+}
+
+// Applies the catch-up policy to the feedings due after the last one run and up to now (RTC seconds),
+//  called on boot and when the clock is set, before the next feeding is armed
+//  the missed feedings are found in a single pass, none while the clock is behind the last feeding run
+//  (RTC lost on a reset, or set back), and only the last CATCHUP_WINDOW counts
+//  the feedings still due after now are dropped when the clock is set back before them, they come round
+//  again at their time; merged or skipped feedings drop all of them, none may run after the merged run
+void catchUpFeeds(uint32_t now)
+{
+    uint32_t from = lastFeedTime;
+    uint32_t latestTime, duration;
+    int16_t latest;
+    FEED_SLOT feed;
+    dropDueFeeds(now, false);
+    if (lastFeedTime == NO_FEED_TIME || now <= lastFeedTime)
+        return;
+    if (now - from > CATCHUP_WINDOW)
+        from = now - CATCHUP_WINDOW;
+    missedFeeds = findMissedFeeds(from, now, &latest, &latestTime, &duration);
+    if (latest < 0)
+        return;
+    if (catchupPolicy == CATCHUP_RUN)
+        addMissedFeeds(from, now);
+    else if (catchupPolicy == CATCHUP_MERGE)
+    {
+        getFeedSlot(latest, &feed);
+        runMergedFeeding(now, duration > MAX_DURATION ? MAX_DURATION : duration, feed.pwm);
+    }
+    else
+        dropDueFeeds(now, true);
+    recordFeedTime(latestTime);
+}
+
+// Starts the merged run waiting or else the next feeding due, if any, call when the auger stops
+//  the hibernate isr must not find the auger idle before the next one starts, it would restart the cursor
+void endFeeding(void)
+{
+    uint32_t state = _disable_interrupts();
+    feeding = false;
+    if (mergedDuration != 0)
+    {
+        runFeeding(mergedDuration, mergedPwm);
+        mergedDuration = 0;
+    }
+    else
+        runNextDue();
+    _restore_interrupts(state);
+}
@@ -0,0 +1,39 @@
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target uC:       TM4C123GH6PM
+// System Clock:    -
+
+#ifndef CATCHUP_H_
+#define CATCHUP_H_
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#define NO_FEED_TIME 0xFFFFFFFF     // last feeding run before the first feeding
+#define CATCHUP_WINDOW SECONDS_PER_DAY  // feedings missed longer ago than this are dropped
+
+// Missed feeding policies, see catchUpFeeds()
+#define CATCHUP_RUN 0               // run every missed feeding, one after the other
+#define CATCHUP_MERGE 1             // run one feeding with the missed auger times added up (default)
+#define CATCHUP_SKIP 2              // only mark them as done
+
+// Starts the auger for duration seconds at pwm percent, endFeeding() must be called when it stops
+typedef void (*FEEDING_CALLBACK)(uint32_t duration, uint32_t pwm);
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void loadCatchUp(FEEDING_CALLBACK start);
+void setCatchUpPolicy(uint8_t policy);
+uint8_t getCatchUpPolicy(void);
+uint32_t getLastFeedTime(void);
+uint16_t getMissedFeeds(void);
+void runAlarmFeeds(uint32_t alarm);
+void catchUpFeeds(uint32_t now);
+void endFeeding(void);
+
+#endif
@@ -0,0 +1,353 @@
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target uC:       host (POSIX)
+// System Clock:    -
+
+// Missed feeding catch-up of catchup.c on the EEPROM model, power outages and clock changes
+//   a week of a random schedule, feedings crowded onto a few times of day with weekdays and date
+//   ranges, is run second by second of events: the alarm as the firmware arms it (runAlarmFeeds), the
+//   auger stopping (endFeeding) and the EEPROM queue drained by the main loop after each
+//   the week is disturbed by power outages of minutes to days (the RAM state is lost and the firmware
+//   boots again from the EEPROM) and by the clock set forward or back, with each catch-up policy
+//   every auger start is checked against a reference that finds the feedings slot by slot: in time
+//   and slot order, none twice, none left out unless the policy or the catch-up window drops it, one
+//   merged run with the right duration and pwm, after the feeding running if any, and no idle auger
+//   while a feeding or a merged run is due
+// usage: catchuptest [weeks], EEPROM_IMAGE names the image (erased first)
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "calendar.h"
+#include "eeprom.h"
+#include "eepromhost.h"
+#include "layout.h"
+#include "schedule.h"
+#include "catchup.h"
+
+#define DEFAULT_WEEKS       300
+#define START_DAY           20744       // 2026-10-18
+#define FEEDS               24
+#define DISTURBANCES        8
+#define NEVER               0xFFFFFFFF
+
+// Something that happens to the feeder at a time of the week
+typedef struct _DISTURBANCE
+{
+    uint32_t at;                        // RTC seconds, half a minute off the feeding times
+    int32_t change;                     // seconds the clock is set forward or back, 0 for an outage
+    uint32_t outage;                    // seconds the power is off
+} DISTURBANCE;
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+FEED_SLOT feeds[MAX_SLOTS];
+DISTURBANCE disturbances[DISTURBANCES];
+const uint32_t outages[] = {300, 2*3600, 20*3600, 3*SECONDS_PER_DAY};
+const int32_t changes[] = {600, 5*3600, 30*3600, -1200, -5*3600};
+
+uint32_t now;                           // simulated RTC
+uint32_t alarm;                         // RTCM0, NEVER when nothing is armed
+bool augerOn;
+uint32_t augerEnd;
+
+// reference: the last feeding run, the feedings due up to refDueUntil, the last one recorded and a merged
+//  run expected
+uint32_t refTime, refDueUntil, refLast;
+int16_t refSlot;
+bool mergeExpected;
+uint32_t mergeDuration, mergePwm;
+
+uint32_t runs, merged, catchUps;
+bool failed = false;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void check(bool ok, const char* what)
+{
+    if (!ok && !failed)
+        printf("catchuptest: FAILED %s at %u\n", what, now);
+    failed |= !ok;
+}
+
+bool occursOn(uint16_t slot, uint32_t day)
+{
+    return (feeds[slot].days & (1 << getWeekday(day))) && day >= feeds[slot].firstDay && day <= feeds[slot].lastDay;
+}
+
+// the first feeding after (time, slot) in time and slot order, from each slot on its own
+int16_t findReference(uint32_t time, int16_t after, uint32_t* when)
+{
+    uint32_t seconds, day, t;
+    int16_t slot, next = -1;
+    uint16_t n;
+    for (slot = 0; slot < MAX_SLOTS; slot++)
+    {
+        if (feeds[slot].flag == SLOT_FREE)
+            continue;
+        seconds = feeds[slot].hour * 3600 + feeds[slot].minute * 60;
+        day = time / SECONDS_PER_DAY;
+        if (seconds < time % SECONDS_PER_DAY || (seconds == time % SECONDS_PER_DAY && slot <= after))
+            day++;
+        for (n = 0; n < 400 && !occursOn(slot, day); n++)
+            day++;
+        t = day * SECONDS_PER_DAY + seconds;
+        if (n < 400 && (next < 0 || t < *when))
+        {
+            next = slot;
+            *when = t;
+        }
+    }
+    return next;
+}
+
+// whether the reference has a feeding due
+bool referenceDue(void)
+{
+    uint32_t when;
+    return findReference(refTime, refSlot, &when) >= 0 && when <= refDueUntil;
+}
+
+// the auger of the firmware, each start is checked against the reference
+void runAuger(uint32_t duration, uint32_t pwm)
+{
+    uint32_t when;
+    int16_t slot;
+    check(!augerOn, "the auger started while running a feeding");
+    augerOn = true;
+    augerEnd = now + duration;
+    if (mergeExpected)
+    {
+        check(duration == mergeDuration && pwm == mergePwm, "merged run");
+        mergeExpected = false;
+        merged++;
+        return;
+    }
+    slot = findReference(refTime, refSlot, &when);
+    check(slot >= 0 && when <= refDueUntil, "a feeding that is not due ran");
+    check(slot >= 0 && duration == feeds[slot].duration && pwm == feeds[slot].pwm, "feeding out of order");
+    refTime = when;
+    refSlot = slot;
+    runs++;
+}
+
+// the reference side of catchUpFeeds(to): what the policy does with the feedings missed since refLast,
+//  returns how many that are, -1 when catchUpFeeds does not look
+int32_t expectCatchUp(uint32_t to, uint8_t policy)
+{
+    uint32_t from = refLast, when, latestTime = 0, duration = 0, count = 0;
+    int16_t slot, latest = -1;
+    if (to < refDueUntil)               // set back before the feedings still due
+    {
+        refTime = refDueUntil = to;
+        refSlot = FEED_CURSOR_END;
+    }
+    if (refLast == NO_FEED_TIME || to <= refLast)
+        return -1;
+    if (to - from > CATCHUP_WINDOW)
+        from = to - CATCHUP_WINDOW;
+    for (slot = findReference(from, FEED_CURSOR_END, &when); slot >= 0 && when <= to;
+            slot = findReference(when, slot, &when))
+    {
+        latest = slot;
+        latestTime = when;
+        duration += feeds[slot].duration;
+        count++;
+    }
+    catchUps++;
+    if (latest < 0)
+        return 0;
+    if (policy == CATCHUP_RUN)
+    {
+        if (refTime < from)             // feedings still due are older than the window
+        {
+            refTime = from;
+            refSlot = FEED_CURSOR_END;
+        }
+        refDueUntil = to;
+    }
+    else                                // every feeding up to to is done
+    {
+        refTime = refDueUntil = to;
+        refSlot = FEED_CURSOR_END;
+        if (policy == CATCHUP_MERGE)    // after the feeding running, with a merged run waiting
+        {
+            duration = duration > MAX_DURATION ? MAX_DURATION : duration;
+            if (mergeExpected)
+                duration += mergeDuration;
+            mergeExpected = true;
+            mergeDuration = duration > MAX_DURATION ? MAX_DURATION : duration;
+            mergePwm = feeds[latest].pwm;
+        }
+    }
+    refLast = latestTime;
+    return count;
+}
+
+// the clock set to to, as setTime: catch-up, then the alarm re-armed
+void setClock(uint32_t to, uint8_t policy)
+{
+    uint32_t when;
+    int32_t missed;
+    if (augerOn)
+        augerEnd += to - now;           // the auger runs on for what is left
+    now = to;
+    missed = expectCatchUp(to, policy);
+    catchUpFeeds(to);
+    check(missed < 0 || getMissedFeeds() == missed, "feedings found missed");
+    check(getLastFeedTime() == refLast, "last feeding run");
+    alarm = findNextFeed(to, FEED_CURSOR_END, &when) < 0 ? NEVER : when;
+}
+
+// the power off for seconds: the running feeding and everything in RAM is lost, then the firmware boots
+void cutPower(uint32_t seconds, uint8_t policy)
+{
+    drainEepromQueue();
+    augerOn = false;
+    mergeExpected = false;              // a merged run waiting is lost with the RAM
+    if (refLast != NO_FEED_TIME)        // the feedings still due are lost with the RAM
+    {
+        refTime = refLast;
+        refSlot = FEED_CURSOR_END;
+    }
+    refDueUntil = refTime;
+    initLayout();
+    validateLayout();
+    loadSchedule();
+    loadCatchUp(runAuger);
+    check(getLastFeedTime() == refLast, "last feeding kept in EEPROM");
+    setClock(now + seconds, policy);
+}
+
+// a random week of feedings from START_DAY, crowded onto a few times of day
+void makeSchedule(void)
+{
+    uint16_t slot, ranges = 0;
+    for (slot = 0; slot < MAX_SLOTS; slot++)
+        if (feeds[slot].flag != SLOT_FREE)
+            clearFeedSlot(slot);
+    for (slot = 0; slot < MAX_SLOTS; slot++)
+    {
+        FEED_SLOT* feed = &feeds[slot];
+        feed->flag = slot < FEEDS && rand() % 6 ? slot : SLOT_FREE;
+        feed->duration = 1 + rand() % MAX_DURATION;
+        feed->pwm = 30 + slot;          // tells the slot of a run
+        feed->hour = 4 * (rand() % 6);
+        feed->minute = rand() % 3 ? 0 : rand() % 2 ? 1 : 45;   // a minute on runs into the chain before
+        feed->days = rand() % 2 ? ALL_DAYS : 1 + rand() % ALL_DAYS;
+        feed->firstDay = 0;
+        feed->lastDay = NO_LAST_DAY;
+        if (feed->flag != SLOT_FREE && ranges < 2 && rand() % 8 == 0)
+        {
+            feed->firstDay = START_DAY + rand() % 7;
+            feed->lastDay = feed->firstDay + rand() % 4;
+            ranges++;
+        }
+        if (feed->flag != SLOT_FREE)
+            check(writeFeedSlot(slot, feed), "writeFeedSlot refused a feeding");
+    }
+}
+
+// a week with its disturbances, from a first boot with no feeding run yet
+void runWeek(uint32_t week)
+{
+    uint32_t start = START_DAY * SECONDS_PER_DAY, end = start + 7 * SECONDS_PER_DAY;
+    uint32_t next, when, bucket = 7 * SECONDS_PER_DAY / DISTURBANCES;
+    uint8_t policy = week % 3, d = 0;
+    DISTURBANCE* disturbance;
+
+    // one in each eighth of the week, half a minute off the feeding times or just into the feedings of a
+    //  time, some clock changes put right again 40 s later
+    makeSchedule();
+    for (d = 0; d < DISTURBANCES; d++)
+    {
+        disturbance = &disturbances[d];
+        disturbance->at = start + d * bucket + rand() % (bucket - 4 * 3600 - 60);
+        if (rand() % 2)
+            disturbance->at += 4 * 3600 - disturbance->at % (4 * 3600) + 5;
+        else
+            disturbance->at -= disturbance->at % 60 - 30;
+        disturbance->change = rand() % 2 ? changes[rand() % 5] : 0;
+        disturbance->outage = outages[rand() % 4];
+        if (d > 0 && disturbances[d - 1].change != 0 && rand() % 3 == 0)
+        {
+            disturbance->at = disturbances[d - 1].at + disturbances[d - 1].change + 40;
+            disturbance->change = -disturbances[d - 1].change;
+        }
+    }
+    queueEepromWrite(EE_LAST_FEED, NO_FEED_TIME);     // no feeding run yet, as on a new feeder
+    setCatchUpPolicy(policy);
+    now = start;
+    refTime = refDueUntil = start;
+    refSlot = FEED_CURSOR_END;
+    refLast = NO_FEED_TIME;
+    mergeExpected = false;
+    cutPower(0, policy);
+
+    for (d = 0; now < end && !failed; )
+    {
+        next = alarm;
+        if (augerOn && augerEnd <= next)
+            next = augerEnd;
+        if (d < DISTURBANCES && disturbances[d].at < next)
+            next = disturbances[d].at > now ? disturbances[d].at : now;
+        if (next >= end)
+            break;
+        now = next;
+        if (augerOn && augerEnd == now)
+        {
+            augerOn = false;
+            endFeeding();
+        }
+        else if (alarm == now)
+        {
+            if (!referenceDue())
+            {
+                refTime = alarm;
+                refSlot = FEED_CURSOR_START;
+            }
+            refDueUntil = refLast = alarm;
+            runAlarmFeeds(alarm);
+            alarm = findNextFeed(alarm, FEED_CURSOR_END, &when) < 0 ? NEVER : when;
+        }
+        else if (disturbances[d].change != 0)
+            setClock(now + disturbances[d++].change, policy);
+        else
+            cutPower(disturbances[d++].outage, policy);
+        drainEepromQueue();
+        check(!mergeExpected || augerOn, "no merged run");
+        check(augerOn || !referenceDue(), "auger idle with a feeding due");
+    }
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t weeks = argc > 1 ? strtoul(argv[1], 0, 10) : DEFAULT_WEEKS;
+    uint32_t week;
+    uint16_t slot;
+
+    initEeprom();
+    eraseEepromImage();
+    initLayout();
+    validateLayout();
+    loadSchedule();
+    for (slot = 0; slot < MAX_SLOTS; slot++)
+        feeds[slot].flag = SLOT_FREE;
+    srand(1);
+    for (week = 0; week < weeks && !failed; week++)
+        runWeek(week);
+    printf("catchuptest: %u weeks with %u outages and clock changes, %u feedings run, %u catch-ups, "
+           "%u merged runs%s\n", week, week * DISTURBANCES, runs, catchUps, merged, failed ? ", FAILED" : "");
+    return failed ? 1 : 0;
+}
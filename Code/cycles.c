@@ -0,0 +1,40 @@
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target uC:       TM4C123GH6PM
+// System Clock:    40 MHz
+
+// Hardware configuration:
+// DWT cycle counter of the Cortex-M4 core, used to measure code paths in cpu clocks
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include "tm4c123gh6pm.h"
+#include "cycles.h"
+
+// DWT registers (not part of tm4c123gh6pm.h)
+#define DWT_CTRL_R          (*((volatile uint32_t *)0xE0001000))
+#define DWT_CYCCNT_R        (*((volatile uint32_t *)0xE0001004))
+#define DWT_CTRL_CYCCNTENA  0x00000001
+#define DEMCR_TRCENA        0x01000000
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+// Starts the free running cycle counter, differences of readCycleCounter() are valid for 107 s at 40 MHz
+void initCycleCounter(void)
+{
+    NVIC_DBG_INT_R |= DEMCR_TRCENA;                 // enable trace blocks (DEMCR)
+    DWT_CYCCNT_R = 0;
+    DWT_CTRL_R |= DWT_CTRL_CYCCNTENA;
+}
+
+uint32_t readCycleCounter(void)
+{
+    return DWT_CYCCNT_R;
+}
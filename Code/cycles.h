@@ -0,0 +1,18 @@
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target uC:       TM4C123GH6PM
+// System Clock:    40 MHz
+
+#ifndef CYCLES_H_
+#define CYCLES_H_
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void initCycleCounter(void);
+uint32_t readCycleCounter(void);
+
+#endif
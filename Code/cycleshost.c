@@ -0,0 +1,32 @@
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target uC:       host (POSIX)
+// System Clock:    -
+
+// Host implementation of cycles.h, the monotonic clock scaled to 40 MHz cycles so the firmware's
+//   cycle counts keep their unit, wrapping like the DWT counter every 107 s
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <time.h>
+#include "cycles.h"
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void initCycleCounter(void)
+{
+}
+
+uint32_t readCycleCounter(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec * 40000000 + t.tv_nsec / 25;
+}
@@ -10,9 +10,27 @@
 //-----------------------------------------------------------------------------
 
 #include <stdint.h>
+#include <stdbool.h>
 #include "tm4c123gh6pm.h"
 #include "eeprom.h"
 
+// Writes queued from interrupts, programmed later by drainEepromQueue()
+//  the hibernate isr, the timer isr and the main loop all queue, so an entry is added with interrupts
+//  disabled; the main loop is the only consumer, one slot is kept empty to tell full from empty
+#define EEPROM_QUEUE_SIZE 32        // room for a visit log block change (16 writes) plus the visit
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+uint16_t queueAddress[EEPROM_QUEUE_SIZE];
+uint32_t queueData[EEPROM_QUEUE_SIZE];
+volatile uint8_t queueWriteIndex = 0;
+volatile uint8_t queueReadIndex = 0;
+uint32_t queueDropped = 0;
+uint32_t writesPerformed = 0;       // words programmed
+uint32_t writesSkipped = 0;         // words that already held the value
+
 //-----------------------------------------------------------------------------
 // Subroutines
 //-----------------------------------------------------------------------------
@@ -24,17 +42,139 @@ void initEeprom(void)
     while (EEPROM_EEDONE_R & EEPROM_EEDONE_WORKING);
 }
 
-void writeEeprom(uint16_t add, uint32_t data)
+// Programs one word and waits for it to finish, a word already holding data is not programmed again
+//  reading it back takes a few cycles, programming takes milliseconds and wears the word
+void programEeprom(uint16_t add, uint32_t data)
 {
     EEPROM_EEBLOCK_R = add >> 4;
     EEPROM_EEOFFSET_R = add & 0xF;
+    if (EEPROM_EERDWR_R == data)
+    {
+        writesSkipped++;
+        return;
+    }
     EEPROM_EERDWR_R = data;
+    writesPerformed++;
     while (EEPROM_EEDONE_R & EEPROM_EEDONE_WORKING);
 }
 
+// Finds the newest queued value for add, returns false when nothing is pending for it
+bool findQueuedEeprom(uint16_t add, uint32_t* data)
+{
+    uint8_t i = queueWriteIndex;
+    while (i != queueReadIndex)
+    {
+        i = (i + EEPROM_QUEUE_SIZE - 1) % EEPROM_QUEUE_SIZE;
+        if (queueAddress[i] == add)
+        {
+            *data = queueData[i];
+            return true;
+        }
+    }
+    return false;
+}
+
+// Queues a write without waiting on the EEPROM, safe to call from an isr
+//  returns false and counts the write as dropped when the queue is full
+bool queueEepromWrite(uint16_t add, uint32_t data)
+{
+    uint32_t state = _disable_interrupts();
+    uint8_t next = (queueWriteIndex + 1) % EEPROM_QUEUE_SIZE;
+    bool queued = next != queueReadIndex;
+    if (queued)
+    {
+        queueAddress[queueWriteIndex] = add;
+        queueData[queueWriteIndex] = data;
+        queueWriteIndex = next;
+    }
+    else
+        queueDropped++;
+    _restore_interrupts(state);
+    return queued;
+}
+
+// Programs every queued write, call from the main loop
+//  an entry stays visible to reads until it has been programmed
+void drainEepromQueue(void)
+{
+    while (queueReadIndex != queueWriteIndex)
+    {
+        programEeprom(queueAddress[queueReadIndex], queueData[queueReadIndex]);
+        queueReadIndex = (queueReadIndex + 1) % EEPROM_QUEUE_SIZE;
+    }
+}
+
+uint32_t getEepromQueueDropped(void)
+{
+    return queueDropped;
+}
+
+void getEepromWriteCounts(uint32_t* performed, uint32_t* skipped)
+{
+    *performed = writesPerformed;
+    *skipped = writesSkipped;
+}
+
+// Writes one word from the main loop, queued writes go first so they cannot overwrite it later
+void writeEeprom(uint16_t add, uint32_t data)
+{
+    drainEepromQueue();
+    programEeprom(add, data);
+}
+
+// Reads one word, a queued write to the same address is returned instead of the stored value
 uint32_t readEeprom(uint16_t add)
 {
+    uint32_t data;
+    if (findQueuedEeprom(add, &data))
+        return data;
     EEPROM_EEBLOCK_R = add >> 4;
     EEPROM_EEOFFSET_R = add & 0xF;
     return EEPROM_EERDWR_R;
 }
+
+// Selects the block and offset of a word address for the next EERDWR/EERDWRINC access
+void seekEeprom(uint16_t add)
+{
+    EEPROM_EEBLOCK_R = add >> 4;
+    EEPROM_EEOFFSET_R = add & 0xF;
+}
+
+// Writes count consecutive words starting at add, skipping words that already hold their value
+//  EERDWRINC only advances the offset and wraps within the block, so the block is reselected at each boundary
+//  and a skipped word advances the offset by hand
+void writeEepromBlock(uint16_t add, const uint32_t* data, uint16_t count)
+{
+    uint16_t i;
+    drainEepromQueue();
+    seekEeprom(add);
+    for (i = 0; i < count; i++)
+    {
+        if (i != 0 && ((add + i) & 0xF) == 0)
+            seekEeprom(add + i);
+        if (EEPROM_EERDWR_R == data[i])
+        {
+            writesSkipped++;
+            EEPROM_EEOFFSET_R = (add + i + 1) & 0xF;
+            continue;
+        }
+        EEPROM_EERDWRINC_R = data[i];
+        writesPerformed++;
+        while (EEPROM_EEDONE_R & EEPROM_EEDONE_WORKING);
+    }
+}
+
+// Reads count consecutive words starting at add
+void readEepromBlock(uint16_t add, uint32_t* data, uint16_t count)
+{
+    uint16_t i;
+    seekEeprom(add);
+    for (i = 0; i < count; i++)
+    {
+        if (i != 0 && ((add + i) & 0xF) == 0)
+            seekEeprom(add + i);
+        data[i] = EEPROM_EERDWRINC_R;
+    }
+    for (i = 0; i < count; i++)
+        findQueuedEeprom(add + i, &data[i]);
+}
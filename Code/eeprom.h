@@ -13,7 +13,13 @@
 //-----------------------------------------------------------------------------
 
 void initEeprom(void);
+bool queueEepromWrite(uint16_t add, uint32_t data);
+void drainEepromQueue(void);
+uint32_t getEepromQueueDropped(void);
+void getEepromWriteCounts(uint32_t* performed, uint32_t* skipped);
 void writeEeprom(uint16_t add, uint32_t data);
 uint32_t readEeprom(uint16_t add);
+void writeEepromBlock(uint16_t add, const uint32_t* data, uint16_t count);
+void readEepromBlock(uint16_t add, uint32_t* data, uint16_t count);
 
 #endif
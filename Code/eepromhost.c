@@ -0,0 +1,253 @@
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target uC:       host (POSIX)
+// System Clock:    -
+
+// Host model of the TM4C123 EEPROM registers, eeprom.c itself runs on top of it in host builds
+//   (tm4c123gh6pmhost.h routes its register accesses here), so the queue, the skip of unchanged
+//   words and the block reselection of the burst functions are the firmware's own code
+// EEBLOCK and EEOFFSET select a word, EERDWR reads or programs it, EERDWRINC does the same and
+//   then advances EEOFFSET, wrapping from 15 to 0 within the same block as the hardware does
+//   a block past the last one stops the run
+// A store to EERDWR/EERDWRINC lands in a latch, which is programmed at the next register access
+//   (eeprom.c always polls EEDONE right after) when it differs from the word, storing the value a
+//   word already holds is not seen, eeprom.c never does
+//
+// The EEPROM is an image file mapped with mmap, EEPROM_IMAGE names it (eeprom.img by default)
+//   and a new image reads as erased, all words 0xFFFFFFFF
+//   the file holds the 32 blocks of 16 words followed by the lifetime write counter of every word,
+//   so wear adds up over several runs on the same image
+// Each programmed word adds EEPROM_PROGRAM_US to the busy time instead of sleeping
+// Words marked as metadata with markEepromMetadata (checksums, layout and migration words, staging
+//   copies) are told apart from data words, the report gives every word programmed per data word
+//   programmed, the cost of the layout's bookkeeping for each change the code makes
+// The wear report is printed to stderr at exit
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "tm4c123gh6pmhost.h"
+#include "eeprom.h"
+#include "eepromhost.h"
+
+#define EEPROM_BLOCKS       32
+#define EEPROM_WORDS        (EEPROM_BLOCKS*16)
+#define EEPROM_ERASED       0xFFFFFFFF
+#define EEPROM_PROGRAM_US   110         // assumed word program time
+#define EEPROM_ENDURANCE    500000      // rated writes per word
+#define HOT_WORDS           8           // words listed by the report
+
+typedef struct _IMAGE
+{
+    uint32_t data[EEPROM_WORDS];
+    uint32_t writes[EEPROM_WORDS];      // lifetime programs of each word
+} IMAGE;
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+// registers
+volatile uint32_t hostRcgcEeprom = 0;
+volatile uint32_t hostEeblock = 0;
+volatile uint32_t hostEeoffset = 0;
+
+IMAGE* image = NULL;
+bool metadata[EEPROM_WORDS];
+
+volatile uint32_t latch;                // EERDWR/EERDWRINC as the code last accessed it
+uint32_t latchWord;                     // the word when it was accessed
+uint16_t latchAddress;
+bool latchOpen = false;
+
+bool powerLossArmed = false;
+uint32_t powerLossPrograms = 0;         // words still programmed before the power fails
+
+// this run only
+uint32_t programmed = 0;                // words programmed
+uint32_t dataProgrammed = 0;            // of those, words not marked as metadata
+uint64_t busyUs = 0;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void reportAtExit(void)
+{
+    reportEepromWear(stderr);
+}
+
+// Maps the image file, creating an erased one when it does not exist yet
+void mapEepromImage(void)
+{
+    const char* path = getenv("EEPROM_IMAGE");
+    uint16_t i;
+    bool created;
+    int fd;
+    if (path == NULL)
+        path = "eeprom.img";
+    fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0)
+    {
+        perror(path);
+        exit(1);
+    }
+    created = lseek(fd, 0, SEEK_END) == 0;
+    if (ftruncate(fd, sizeof(IMAGE)) != 0)
+    {
+        perror(path);
+        exit(1);
+    }
+    image = mmap(NULL, sizeof(IMAGE), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (image == MAP_FAILED)
+    {
+        perror(path);
+        exit(1);
+    }
+    if (created)
+        for (i = 0; i < EEPROM_WORDS; i++)
+            image->data[i] = EEPROM_ERASED;
+    atexit(reportAtExit);
+}
+
+// Counts one program toward the power cut, the flash model counts its programs and erases here too
+void checkEepromPowerLoss(void)
+{
+    if (powerLossArmed && powerLossPrograms-- == 0)
+        _exit(EEPROM_POWER_LOST);
+}
+
+void programWord(uint16_t add, uint32_t data)
+{
+    checkEepromPowerLoss();
+    image->data[add] = data;
+    image->writes[add]++;
+    programmed++;
+    if (!metadata[add])
+        dataProgrammed++;
+    busyUs += EEPROM_PROGRAM_US;
+}
+
+// Programs a value stored in the latch since the last access, before any other register access
+void syncLatch(void)
+{
+    if (image == NULL)
+        mapEepromImage();
+    if (latchOpen && latch != latchWord)
+        programWord(latchAddress, latch);
+    latchOpen = false;
+}
+
+// EERDWR (increment false) or EERDWRINC, the word selected by EEBLOCK and EEOFFSET
+volatile uint32_t* accessEepromWord(bool increment)
+{
+    syncLatch();
+    if (hostEeblock >= EEPROM_BLOCKS)
+    {
+        fprintf(stderr, "eeprom: EEBLOCK %u is past block %u\n", hostEeblock, EEPROM_BLOCKS - 1);
+        abort();
+    }
+    latchAddress = hostEeblock*16 + (hostEeoffset & 0xF);
+    latchWord = image->data[latchAddress];
+    latch = latchWord;
+    latchOpen = true;
+    if (increment)
+        hostEeoffset = (hostEeoffset + 1) & 0xF;
+    return &latch;
+}
+
+// EEDONE, programming finishes at once, the time is added to the busy total instead
+uint32_t readEepromDone(void)
+{
+    syncLatch();
+    return 0;
+}
+
+// Counts count words from add as metadata in the report
+void markEepromMetadata(uint16_t add, uint16_t count)
+{
+    for (; count != 0 && add < EEPROM_WORDS; count--)
+        metadata[add++] = true;
+}
+
+// Cuts the power once programs more words have been programmed, the next program exits the run with
+//  EEPROM_POWER_LOST and nothing else is written, the image keeps what was programmed before it
+void setEepromPowerLoss(uint32_t programs)
+{
+    powerLossArmed = true;
+    powerLossPrograms = programs;
+}
+
+// Erases every word and clears this run's counts, the lifetime write counters are kept
+void eraseEepromImage(void)
+{
+    uint16_t i;
+    syncLatch();
+    for (i = 0; i < EEPROM_WORDS; i++)
+        image->data[i] = EEPROM_ERASED;
+    programmed = 0;
+    dataProgrammed = 0;
+    busyUs = 0;
+}
+
+void getEepromProgramCounts(uint32_t* words, uint32_t* dataWords)
+{
+    syncLatch();
+    *words = programmed;
+    *dataWords = dataProgrammed;
+}
+
+uint64_t getEepromBusyMicroseconds(void)
+{
+    return busyUs;
+}
+
+// Prints this run's write counts and the words with the most lifetime writes
+void reportEepromWear(FILE* out)
+{
+    uint16_t hot[HOT_WORDS];
+    uint16_t i, j, k;
+    uint32_t performed, skipped;
+    if (image == NULL)
+        return;
+    syncLatch();
+    getEepromWriteCounts(&performed, &skipped);
+    fprintf(out, "eeprom: %u words programmed, %u data and %u metadata, %u skipped unchanged, %llu us busy\n",
+            programmed, dataProgrammed, programmed - dataProgrammed, skipped, (unsigned long long)busyUs);
+    if (performed != programmed)
+        fprintf(out, "eeprom: eeprom.c counted %u words programmed\n", performed);
+    if (dataProgrammed != 0 && dataProgrammed != programmed)
+        fprintf(out, "eeprom: %u.%02u words programmed per data word changed\n",
+                programmed / dataProgrammed, (programmed % dataProgrammed) * 100 / dataProgrammed);
+    for (i = 0; i < HOT_WORDS; i++)
+        hot[i] = EEPROM_WORDS;
+    for (i = 0; i < EEPROM_WORDS; i++)
+    {
+        if (image->writes[i] == 0)
+            continue;
+        for (j = 0; j < HOT_WORDS; j++)
+            if (hot[j] == EEPROM_WORDS || image->writes[i] > image->writes[hot[j]])
+                break;
+        if (j == HOT_WORDS)
+            continue;
+        for (k = HOT_WORDS - 1; k > j; k--)
+            hot[k] = hot[k - 1];
+        hot[j] = i;
+    }
+    for (i = 0; i < HOT_WORDS && hot[i] != EEPROM_WORDS; i++)
+        fprintf(out, "eeprom: word %3u (block %2u offset %2u) %u writes, %u.%02u%% of endurance\n",
+                hot[i], hot[i] >> 4, hot[i] & 0xF, image->writes[hot[i]],
+                image->writes[hot[i]] / (EEPROM_ENDURANCE / 100),
+                image->writes[hot[i]] % (EEPROM_ENDURANCE / 100) * 100 / (EEPROM_ENDURANCE / 100));
+}
@@ -0,0 +1,32 @@
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target uC:       host (POSIX)
+// System Clock:    -
+
+#ifndef EEPROMHOST_H_
+#define EEPROMHOST_H_
+
+#include <stdio.h>
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#define EEPROM_POWER_LOST   75          // exit status when setEepromPowerLoss cuts the power
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+// the EEPROM register model of eepromhost.c, these only exist in host builds
+void markEepromMetadata(uint16_t add, uint16_t count);
+void setEepromPowerLoss(uint32_t programs);
+void checkEepromPowerLoss(void);
+void eraseEepromImage(void);
+void getEepromProgramCounts(uint32_t* words, uint32_t* dataWords);
+uint64_t getEepromBusyMicroseconds(void);
+void reportEepromWear(FILE* out);
+
+#endif
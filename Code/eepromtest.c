@@ -0,0 +1,182 @@
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target uC:       host (POSIX)
+// System Clock:    -
+
+// readEepromBlock and writeEepromBlock on the register model of eepromhost.c
+//   bursts that start, end and cross the 16-word block boundaries, where EERDWRINC wraps within the
+//   block and the functions must reselect the next one, bursts over the whole EEPROM, rewrites of
+//   unchanged and partly changed data (a skipped word advances EEOFFSET by hand), queued writes seen
+//   by a burst read, then random bursts and single words against a copy kept in RAM
+//   every word is read back both ways and the words programmed must match what changed
+// usage: eepromtest [random bursts], EEPROM_IMAGE names the image (erased first)
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "eeprom.h"
+#include "eepromhost.h"
+
+#define EEPROM_WORDS        512
+#define DEFAULT_BURSTS      20000
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+uint32_t copy[EEPROM_WORDS];            // what the EEPROM should hold
+uint32_t data[EEPROM_WORDS];
+bool failed = false;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void check(bool ok, const char* what, uint16_t add, uint16_t count)
+{
+    if (!ok && !failed)                 // the first failure only, the rest follow from it
+        printf("eepromtest: FAILED %s, burst of %u words at %u\n", what, count, add);
+    failed |= !ok;
+}
+
+uint32_t getProgrammed(void)
+{
+    uint32_t words, dataWords;
+    getEepromProgramCounts(&words, &dataWords);
+    return words;
+}
+
+// every word, by burst and one at a time, against the copy
+void checkAll(const char* what)
+{
+    uint16_t i;
+    readEepromBlock(0, data, EEPROM_WORDS);
+    for (i = 0; i < EEPROM_WORDS; i++)
+        check(data[i] == copy[i], what, i, 1);
+    for (i = 0; i < EEPROM_WORDS; i++)
+        check(readEeprom(i) == copy[i], what, i, 1);
+}
+
+// writes a burst from data, checks it programmed the words that changed and nothing else
+void burst(uint16_t add, uint16_t count, const char* what)
+{
+    uint32_t before = getProgrammed(), changed = 0, performed, skipped, skippedBefore;
+    uint16_t i;
+    getEepromWriteCounts(&performed, &skippedBefore);
+    for (i = 0; i < count; i++)
+    {
+        changed += copy[add + i] != data[i];
+        copy[add + i] = data[i];
+    }
+    writeEepromBlock(add, data, count);
+    getEepromWriteCounts(&performed, &skipped);
+    check(getProgrammed() - before == changed, what, add, count);
+    check(skipped - skippedBefore == count - changed, what, add, count);
+    readEepromBlock(add, data, count);
+    for (i = 0; i < count; i++)
+        check(data[i] == copy[add + i], what, add, count);
+}
+
+void fill(uint16_t count, uint32_t seed)
+{
+    uint16_t i;
+    for (i = 0; i < count; i++)
+        data[i] = seed * 2654435761u + i;
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t bursts = argc > 1 ? strtoul(argv[1], 0, 10) : DEFAULT_BURSTS;
+    uint32_t r, before;
+    uint16_t i, add, count;
+
+    initEeprom();
+    eraseEepromImage();
+    for (i = 0; i < EEPROM_WORDS; i++)
+        copy[i] = 0xFFFFFFFF;
+    checkAll("erased image");
+
+    // block boundaries: inside one block, ending on the last word, starting on the first,
+    //   crossing one boundary and crossing several
+    fill(5, 1);
+    burst(3, 5, "burst inside a block");
+    fill(4, 2);
+    burst(28, 4, "burst ending on a block's last word");
+    fill(16, 3);
+    burst(32, 16, "burst of one whole block");
+    fill(10, 4);
+    burst(59, 10, "burst crossing a block boundary");
+    fill(70, 5);
+    burst(75, 70, "burst crossing several blocks");
+    fill(1, 6);
+    burst(511, 1, "last word");
+    checkAll("after the boundary bursts");
+
+    // whole EEPROM, then unchanged (every word skipped), then every other word changed, so
+    //   skips advance the offset by hand across the boundaries
+    fill(EEPROM_WORDS, 7);
+    burst(0, EEPROM_WORDS, "whole EEPROM");
+    burst(0, EEPROM_WORDS, "unchanged rewrite");
+    for (i = 0; i < EEPROM_WORDS; i += 2)
+        data[i] ^= 0x5A5A;
+    burst(0, EEPROM_WORDS, "every other word changed");
+    readEepromBlock(13, data, 40);
+    data[2] ^= 1;                       // word 15, last of block 0, changed
+    data[3] ^= 1;                       // word 16, first of block 1
+    burst(13, 40, "changes on both sides of a boundary");
+    readEepromBlock(13, data, 40);
+    data[3] ^= 1;                       // word 16 only, the skip of word 15 must reach it
+    burst(13, 40, "skip just before a boundary");
+    checkAll("after the rewrites");
+
+    // queued writes are returned by burst reads before they are programmed
+    before = getProgrammed();
+    queueEepromWrite(47, 0x12345678);
+    queueEepromWrite(48, 0x9ABCDEF0);
+    copy[47] = 0x12345678;
+    copy[48] = 0x9ABCDEF0;
+    readEepromBlock(40, data, 16);
+    check(data[7] == 0x12345678 && data[8] == 0x9ABCDEF0, "queued writes in a burst read", 40, 16);
+    check(getProgrammed() == before, "queued writes programmed by a read", 40, 16);
+    drainEepromQueue();
+    checkAll("after the queue drained");
+
+    // random bursts and single words
+    srand(1);
+    for (r = 0; r < bursts; r++)
+    {
+        add = rand() % EEPROM_WORDS;
+        count = 1 + rand() % (rand() % 4 ? 40 : EEPROM_WORDS - add);
+        if (add + count > EEPROM_WORDS)
+            count = EEPROM_WORDS - add;
+        if (rand() % 3 == 0)
+        {
+            readEepromBlock(add, data, count);
+            for (i = 0; i < count; i++)
+                if (rand() % 4 == 0)
+                    data[i] = rand();
+        }
+        else
+            fill(count, r);
+        if (rand() % 8 == 0)
+        {
+            writeEeprom(add, data[0]);
+            copy[add] = data[0];
+            check(readEeprom(add) == data[0], "single word", add, 1);
+        }
+        else
+            burst(add, count, "random burst");
+    }
+    checkAll("after the random bursts");
+
+    printf("eepromtest: %u random bursts, %u words programmed%s\n", bursts, getProgrammed(),
+           failed ? ", FAILED" : "");
+    return failed ? 1 : 0;
+}
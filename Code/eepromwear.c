@@ -0,0 +1,105 @@
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target uC:       host (POSIX)
+// System Clock:    -
+
+// EEPROM wear of a command workload, on the register model of eepromhost.c
+//   boots the layout on an erased image, then edits feedings as the feed command does, one per line and
+//   then ten per line, and logs a visit every few minutes as the motion interrupt does, draining the
+//   write queue like the main loop
+//   the checksum, layout, migration and staging words are marked as metadata, so the report gives
+//   the words programmed per data word changed
+// usage: eepromwear [feed edits [visits]], EEPROM_IMAGE names the image (erased first)
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "eeprom.h"
+#include "eepromhost.h"
+#include "layout.h"
+#include "schedule.h"
+#include "visitlog.h"
+
+#define DEFAULT_FEED_EDITS  2000
+#define DEFAULT_VISITS      20000
+#define BATCH_EDITS         10          // feed commands on one line
+#define START_TIME          1792281600  // 2026-10-18 00:00
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+// Edits random feedings as the feed command does, batch at a time as one command line, and prints the
+//  words programmed per edit
+void editFeeds(uint32_t edits, uint16_t batch)
+{
+    uint32_t i, before, words, dataWords;
+    uint16_t slot;
+    FEED_SLOT feed;
+    getEepromProgramCounts(&before, &dataWords);
+    for (i = 0; i < edits; i++)
+    {
+        if (i % batch == 0)
+            deferFeedWrites();
+        slot = rand() % 32;
+        if (rand() % 4 == 0)
+            clearFeedSlot(slot);
+        else
+        {
+            feed.flag = slot;
+            feed.duration = 1 + rand() % MAX_DURATION;
+            feed.pwm = 50 + rand() % 51;
+            feed.hour = rand() % 24;
+            feed.minute = rand() % 60;
+            feed.days = 0x7F;
+            feed.firstDay = 0;
+            feed.lastDay = NO_LAST_DAY;
+            writeFeedSlot(slot, &feed);
+        }
+        if (i % batch == batch - 1 || i == edits - 1)
+            commitFeedWrites();
+    }
+    getEepromProgramCounts(&words, &dataWords);
+    words -= before;
+    printf("eepromwear: %u feed edits in lines of %u, %u.%02u words programmed per edit\n", edits, batch,
+           edits ? words / edits : 0, edits ? words % edits * 100 / edits : 0);
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t edits = argc > 1 ? strtoul(argv[1], 0, 10) : DEFAULT_FEED_EDITS;
+    uint32_t visits = argc > 2 ? strtoul(argv[2], 0, 10) : DEFAULT_VISITS;
+    uint32_t i, now = START_TIME, words, dataWords;
+
+    initEeprom();
+    eraseEepromImage();
+    markEepromMetadata(EE_LAYOUT, 1);
+    markEepromMetadata(EE_CONFIG_CRC, 6);
+    markEepromMetadata(EE_MIGRATION, 1);
+    initLayout();
+    validateLayout();
+    loadSchedule();
+    initVisitLog();
+    getEepromProgramCounts(&words, &dataWords);
+    printf("eepromwear: boot on an erased image programmed %u words\n", words);
+
+    srand(1);
+    editFeeds(edits, 1);
+    editFeeds(edits, BATCH_EDITS);
+
+    for (i = 0; i < visits; i++)
+    {
+        now += 60 * (1 + rand() % 10);
+        appendVisit(now);
+        drainEepromQueue();
+    }
+    printf("eepromwear: %u visits logged, %u visits kept\n", visits, getVisitCount());
+    return 0;
+}
@@ -0,0 +1,52 @@
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target uC:       TM4C123GH6PM
+// System Clock:    -
+
+// Flash erase and program through the flash memory controller, for staging data outside the EEPROM
+//   the core stalls while a page erases or a word programs, no interrupt handler runs from flash that
+//   is being written, the staging pages hold no code
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "tm4c123gh6pm.h"
+#include "flash.h"
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+// Erases the 1 KB page at address, every word reads FLASH_ERASED afterwards
+void eraseFlashPage(uint32_t address)
+{
+    FLASH_FMA_R = address;
+    FLASH_FMC_R = FLASH_FMC_WRKEY | FLASH_FMC_ERASE;
+    while (FLASH_FMC_R & FLASH_FMC_ERASE);
+}
+
+// Programs count words from address, programming only clears bits so the words must be erased first
+//  a word that stays erased is not programmed
+void programFlash(uint32_t address, const uint32_t* data, uint16_t count)
+{
+    for (; count != 0; count--, address += 4, data++)
+    {
+        if (*data == FLASH_ERASED)
+            continue;
+        FLASH_FMA_R = address;
+        FLASH_FMD_R = *data;
+        FLASH_FMC_R = FLASH_FMC_WRKEY | FLASH_FMC_WRITE;
+        while (FLASH_FMC_R & FLASH_FMC_WRITE);
+    }
+}
+
+void readFlash(uint32_t address, uint32_t* data, uint16_t count)
+{
+    for (; count != 0; count--, address += 4)
+        *data++ = FLASH_WORD(address);
+}
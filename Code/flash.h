@@ -0,0 +1,36 @@
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target uC:       TM4C123GH6PM
+// System Clock:    -
+
+#ifndef FLASH_H_
+#define FLASH_H_
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+// The last two 1 KB pages of flash hold a copy of the EEPROM words being committed (see layout.c),
+//   word i of the EEPROM at FLASH_STAGE + 4*i, the program must stay below FLASH_STAGE
+//   (FLASH length 0x0003F800 in the linker command file)
+#define FLASH_PAGE_SIZE     1024
+#define FLASH_STAGE         0x0003F800
+#define FLASH_STAGE_PAGES   2
+#define FLASH_ERASED        0xFFFFFFFF
+
+// A flash word as the core reads it, host builds redefine it
+#ifndef FLASH_WORD
+#define FLASH_WORD(address) (*((volatile uint32_t*)(address)))
+#endif
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void eraseFlashPage(uint32_t address);
+void programFlash(uint32_t address, const uint32_t* data, uint16_t count);
+void readFlash(uint32_t address, uint32_t* data, uint16_t count);
+
+#endif
@@ -0,0 +1,147 @@
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target uC:       host (POSIX)
+// System Clock:    -
+
+// Host model of the flash memory controller over the staging pages, flash.c itself runs on top of
+//   it in host builds (tm4c123gh6pmhost.h routes its register accesses and flash reads here)
+// A store to FMC lands in a latch acted on at the next FMC access (flash.c always polls it right
+//   after): with the write key, WRITE programs FMD at FMA, clearing the bits that are 0 in FMD as
+//   flash does, and ERASE sets the page at FMA to all ones
+//   an address outside the staging pages stops the run
+// Each program and each erase counts toward the EEPROM model's power cut (setEepromPowerLoss), so a
+//   cut falls between any two steps of a commit, on either memory
+//
+// The pages are an image file mapped with mmap, FLASH_IMAGE names it (flash.img by default) and a
+//   new image reads as erased
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "tm4c123gh6pmhost.h"
+#include "flash.h"
+#include "eepromhost.h"
+#include "flashhost.h"
+
+#define FLASH_WORDS         (FLASH_STAGE_PAGES*FLASH_PAGE_SIZE/4)
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+// registers
+volatile uint32_t hostFlashFma = 0;
+volatile uint32_t hostFlashFmd = 0;
+volatile uint32_t flashControl = 0;     // FMC as the code last stored it
+
+uint32_t* pages = NULL;
+
+// this run only
+uint32_t flashPrograms = 0;
+uint32_t flashErases = 0;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+// Maps the image file, creating an erased one when it does not exist yet
+void mapFlashImage(void)
+{
+    const char* path = getenv("FLASH_IMAGE");
+    uint16_t i;
+    bool created;
+    int fd;
+    if (path == NULL)
+        path = "flash.img";
+    fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0)
+    {
+        perror(path);
+        exit(1);
+    }
+    created = lseek(fd, 0, SEEK_END) == 0;
+    if (ftruncate(fd, FLASH_WORDS * 4) != 0)
+    {
+        perror(path);
+        exit(1);
+    }
+    pages = mmap(NULL, FLASH_WORDS * 4, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (pages == MAP_FAILED)
+    {
+        perror(path);
+        exit(1);
+    }
+    if (created)
+        for (i = 0; i < FLASH_WORDS; i++)
+            pages[i] = FLASH_ERASED;
+}
+
+// Index of the staging word at address
+uint16_t findFlashWord(uint32_t address)
+{
+    if (pages == NULL)
+        mapFlashImage();
+    if (address < FLASH_STAGE || address >= FLASH_STAGE + FLASH_WORDS * 4 || (address & 3) != 0)
+    {
+        fprintf(stderr, "flash: address 0x%08X is not a staging page word\n", address);
+        abort();
+    }
+    return (address - FLASH_STAGE) / 4;
+}
+
+// FMC, carrying out the operation stored since the last access
+volatile uint32_t* accessFlashControl(void)
+{
+    uint16_t i, word;
+    if ((flashControl & 0xFFFF0000) == FLASH_FMC_WRKEY && (flashControl & FLASH_FMC_WRITE))
+    {
+        word = findFlashWord(hostFlashFma);
+        checkEepromPowerLoss();
+        pages[word] &= hostFlashFmd;
+        flashPrograms++;
+    }
+    else if ((flashControl & 0xFFFF0000) == FLASH_FMC_WRKEY && (flashControl & FLASH_FMC_ERASE))
+    {
+        word = findFlashWord(hostFlashFma & ~(FLASH_PAGE_SIZE - 1));
+        checkEepromPowerLoss();
+        for (i = 0; i < FLASH_PAGE_SIZE / 4; i++)
+            pages[word + i] = FLASH_ERASED;
+        flashErases++;
+    }
+    flashControl = 0;
+    return &flashControl;
+}
+
+const volatile uint32_t* accessFlashWord(uint32_t address)
+{
+    return &pages[findFlashWord(address)];
+}
+
+// Erases the staging pages and clears this run's counts
+void eraseFlashImage(void)
+{
+    uint16_t i;
+    if (pages == NULL)
+        mapFlashImage();
+    for (i = 0; i < FLASH_WORDS; i++)
+        pages[i] = FLASH_ERASED;
+    flashPrograms = 0;
+    flashErases = 0;
+}
+
+void getFlashCounts(uint32_t* programs, uint32_t* erases)
+{
+    *programs = flashPrograms;
+    *erases = flashErases;
+}
@@ -0,0 +1,19 @@
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target uC:       host (POSIX)
+// System Clock:    -
+
+#ifndef FLASHHOST_H_
+#define FLASHHOST_H_
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+// the flash controller model of flashhost.c, these only exist in host builds
+void eraseFlashImage(void);
+void getFlashCounts(uint32_t* programs, uint32_t* erases);
+
+#endif
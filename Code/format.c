@@ -0,0 +1,104 @@
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target uC:       TM4C123GH6PM
+// System Clock:    -
+
+// Small re-entrant replacement for the few snprintf conversions the shell uses
+//   (%u, %02u, HH:MM:SS, dates); every function writes at out, returns the position after
+//   the last character written and does not add a null terminator
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "calendar.h"
+#include "format.h"
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+// Copies str without its null terminator
+char* formatString(char* out, const char* str)
+{
+    while (*str)
+        *out++ = *str++;
+    return out;
+}
+
+// Writes value in decimal, zero padded to at least width digits (width 2 is %02d)
+char* formatUnsigned(char* out, uint32_t value, uint8_t width)
+{
+    uint32_t divisor = 1000000000;
+    uint8_t digits = 10;
+    while (divisor > 1 && value < divisor && digits > width)
+    {
+        divisor /= 10;
+        digits--;
+    }
+    while (divisor)
+    {
+        *out++ = '0' + (value / divisor) % 10;
+        divisor /= 10;
+    }
+    return out;
+}
+
+// Writes length bytes as two lowercase hex digits each
+char* formatHexBytes(char* out, const uint8_t* data, uint16_t length)
+{
+    static const char digits[] = "0123456789abcdef";
+    while (length--)
+    {
+        *out++ = digits[*data >> 4];
+        *out++ = digits[*data++ & 0x0F];
+    }
+    return out;
+}
+
+// Writes seconds as HH:MM or HH:MM:SS
+char* formatTime(char* out, uint32_t seconds, bool showSeconds)
+{
+    out = formatUnsigned(out, seconds / 3600, 2);
+    *out++ = ':';
+    out = formatUnsigned(out, (seconds % 3600) / 60, 2);
+    if (showSeconds)
+    {
+        *out++ = ':';
+        out = formatUnsigned(out, seconds % 60, 2);
+    }
+    return out;
+}
+
+// Writes a day number as YYYY-MM-DD and the weekday, "2026-10-17 Sat"
+char* formatDate(char* out, uint32_t days)
+{
+    static const char names[] = "SunMonTueWedThuFriSat";
+    uint32_t year, month, day;
+    uint8_t weekday = getWeekday(days);
+    civilFromDays(days, &year, &month, &day);
+    out = formatUnsigned(out, year, 4);
+    *out++ = '-';
+    out = formatUnsigned(out, month, 2);
+    *out++ = '-';
+    out = formatUnsigned(out, day, 2);
+    *out++ = ' ';
+    *out++ = names[3*weekday];
+    *out++ = names[3*weekday + 1];
+    *out++ = names[3*weekday + 2];
+    return out;
+}
+
+// Writes a weekday mask as 7 letters from Sunday, '-' for the days not in it, "-MTWTF-"
+char* formatWeekdays(char* out, uint8_t mask)
+{
+    static const char letters[] = "SMTWTFS";
+    uint8_t i;
+    for (i = 0; i < 7; i++)
+        *out++ = (mask & (1 << i)) ? letters[i] : '-';
+    return out;
+}
@@ -0,0 +1,22 @@
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target uC:       TM4C123GH6PM
+// System Clock:    -
+
+#ifndef FORMAT_H_
+#define FORMAT_H_
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+char* formatString(char* out, const char* str);
+char* formatUnsigned(char* out, uint32_t value, uint8_t width);
+char* formatHexBytes(char* out, const uint8_t* data, uint16_t length);
+char* formatTime(char* out, uint32_t seconds, bool showSeconds);
+char* formatDate(char* out, uint32_t days);
+char* formatWeekdays(char* out, uint8_t mask);
+
+#endif
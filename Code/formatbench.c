@@ -0,0 +1,243 @@
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target uC:       host (POSIX)
+// System Clock:    -
+
+// format.c against snprintf on the lines the shell prints: the schedule report lines of
+//   timeCommand and the date and time line of putDateTimeUart0, built the same way as there
+//   both must produce the same characters; reports ns per line and, on x86, TSC ticks per line
+// Built with -DFOOTPRINT=0/1/2 the main below formats one schedule line with nothing, format.c or
+//   snprintf, linked without the C runtime start files so only what the line needs is in the
+//   text; the Makefile compares the sizes, these programs are not meant to run
+// usage: formatbench [rounds]
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define readTicks() __rdtsc()
+#else
+#define readTicks() 0
+#endif
+#include "calendar.h"
+#include "format.h"
+#include "schedule.h"
+
+#define DEFAULT_ROUNDS 200000
+#define LINE_SIZE 80
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+const FEED_SLOT feeds[] =
+{
+    {0, 7, 65, 7, 30, ALL_DAYS, 0, NO_LAST_DAY},
+    {12, 5, 80, 12, 0, WEEKDAYS, 0, NO_LAST_DAY},
+    {200, 63, 100, 18, 30, 0x43, 20807, 20821},      // 2026-12-20 to 2027-01-03
+    {3, 10, 50, 6, 5, WEEKEND_DAYS, 20743, NO_LAST_DAY},
+};
+#define FEED_COUNT (sizeof(feeds)/sizeof(feeds[0]))
+
+const uint32_t times[] = {1792218567, 1792195200, 4291747199, 1798761599};
+#define TIME_COUNT (sizeof(times)/sizeof(times[0]))
+
+const char names[] = "SunMonTueWedThuFriSat";
+volatile uint32_t sink;                 // keeps the lines from being optimized away
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+// one line of the schedule report, as timeCommand builds it
+char* formatFeedLine(char* out, const FEED_SLOT* feed)
+{
+    out = formatUnsigned(out, feed->flag, 1);
+    *out++ = '\t';
+    out = formatUnsigned(out, feed->duration, 1);
+    *out++ = '\t';
+    out = formatUnsigned(out, feed->pwm, 1);
+    *out++ = '\t';
+    out = formatUnsigned(out, feed->hour, 2);
+    *out++ = ':';
+    out = formatUnsigned(out, feed->minute, 2);
+    *out++ = '\t';
+    out = formatWeekdays(out, feed->days);
+    if (feed->firstDay != 0 || feed->lastDay != NO_LAST_DAY)
+    {
+        *out++ = '\t';
+        if (feed->firstDay != 0)
+            out = formatDate(out, feed->firstDay);
+        out = formatString(out, " to ");
+        if (feed->lastDay != NO_LAST_DAY)
+            out = formatDate(out, feed->lastDay);
+    }
+    *out++ = '\n';
+    return out;
+}
+
+#if !defined(FOOTPRINT) || FOOTPRINT == 2
+
+// the same line through snprintf, the weekday letters and names still need a loop or a table
+int printFeedLine(char* out, const FEED_SLOT* feed)
+{
+    static const char letters[] = "SMTWTFS";
+    char days[8], first[16] = "", last[16] = "";
+    uint32_t year, month, day;
+    uint8_t i, weekday;
+    for (i = 0; i < 7; i++)
+        days[i] = (feed->days & (1 << i)) ? letters[i] : '-';
+    days[7] = 0;
+    if (feed->firstDay == 0 && feed->lastDay == NO_LAST_DAY)
+        return snprintf(out, LINE_SIZE, "%u\t%u\t%u\t%02u:%02u\t%s\n", feed->flag, feed->duration,
+                        feed->pwm, feed->hour, feed->minute, days);
+    if (feed->firstDay != 0)
+    {
+        civilFromDays(feed->firstDay, &year, &month, &day);
+        weekday = getWeekday(feed->firstDay);
+        snprintf(first, sizeof(first), "%04u-%02u-%02u %.3s", year, month, day, &names[3*weekday]);
+    }
+    if (feed->lastDay != NO_LAST_DAY)
+    {
+        civilFromDays(feed->lastDay, &year, &month, &day);
+        weekday = getWeekday(feed->lastDay);
+        snprintf(last, sizeof(last), "%04u-%02u-%02u %.3s", year, month, day, &names[3*weekday]);
+    }
+    return snprintf(out, LINE_SIZE, "%u\t%u\t%u\t%02u:%02u\t%s\t%s to %s\n", feed->flag, feed->duration,
+                    feed->pwm, feed->hour, feed->minute, days, first, last);
+}
+
+#endif
+
+// the date and time line of putDateTimeUart0 with seconds
+char* formatTimeLine(char* out, uint32_t seconds)
+{
+    out = formatDate(out, seconds/SECONDS_PER_DAY);
+    *out++ = ' ';
+    out = formatTime(out, seconds%SECONDS_PER_DAY, true);
+    *out++ = '\n';
+    return out;
+}
+
+#if !defined(FOOTPRINT) || FOOTPRINT == 2
+
+int printTimeLine(char* out, uint32_t seconds)
+{
+    uint32_t year, month, day, time = seconds%SECONDS_PER_DAY;
+    civilFromDays(seconds/SECONDS_PER_DAY, &year, &month, &day);
+    return snprintf(out, LINE_SIZE, "%04u-%02u-%02u %.3s %02u:%02u:%02u\n", year, month, day,
+                    &names[3*getWeekday(seconds/SECONDS_PER_DAY)], time / 3600, (time % 3600) / 60, time % 60);
+}
+
+#endif
+
+#ifdef FOOTPRINT
+
+int main(int argc, char** argv)
+{
+    char line[LINE_SIZE];
+#if FOOTPRINT == 1
+    sink = formatFeedLine(line, &feeds[argc % FEED_COUNT]) - line;
+#elif FOOTPRINT == 2
+    sink = printFeedLine(line, &feeds[argc % FEED_COUNT]);
+#else
+    line[0] = argc;
+    sink = line[0] + feeds[argc % FEED_COUNT].pwm;
+#endif
+    return 0;
+}
+
+void _start(void)
+{
+    main(1, 0);
+    while (true);
+}
+
+#else
+
+uint64_t nowNs(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec * 1000000000 + t.tv_nsec;
+}
+
+void report(const char* what, uint64_t ns, uint64_t ticks, uint32_t lines)
+{
+    printf("%-28s %6.1f ns/line", what, (double)ns / lines);
+    if (ticks)
+        printf(", %6.1f TSC ticks/line", (double)ticks / lines);
+    printf("\n");
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t rounds = argc > 1 ? strtoul(argv[1], 0, 10) : DEFAULT_ROUNDS;
+    uint32_t r, i, length;
+    char line[LINE_SIZE], expected[LINE_SIZE];
+    uint64_t start, ticks;
+    bool failed = false;
+
+    for (i = 0; i < FEED_COUNT; i++)
+    {
+        length = printFeedLine(expected, &feeds[i]);
+        if (formatFeedLine(line, &feeds[i]) - line != length || memcmp(line, expected, length) != 0)
+        {
+            printf("formatbench: FAILED schedule line %u differs: %.*s", i, (int)length, expected);
+            failed = true;
+        }
+    }
+    for (i = 0; i < TIME_COUNT; i++)
+    {
+        length = printTimeLine(expected, times[i]);
+        if (formatTimeLine(line, times[i]) - line != length || memcmp(line, expected, length) != 0)
+        {
+            printf("formatbench: FAILED time line %u differs: %.*s", i, (int)length, expected);
+            failed = true;
+        }
+    }
+
+    printf("formatbench: %u schedule lines and %u time lines x %u rounds\n", (unsigned)FEED_COUNT,
+           (unsigned)TIME_COUNT, rounds);
+    start = nowNs();
+    ticks = readTicks();
+    for (r = 0; r < rounds; r++)
+        for (i = 0; i < FEED_COUNT; i++)
+            sink += formatFeedLine(line, &feeds[i]) - line;
+    ticks = readTicks() - ticks;
+    report("schedule line, format.c", nowNs() - start, ticks, rounds * FEED_COUNT);
+    start = nowNs();
+    ticks = readTicks();
+    for (r = 0; r < rounds; r++)
+        for (i = 0; i < FEED_COUNT; i++)
+            sink += printFeedLine(line, &feeds[i]);
+    ticks = readTicks() - ticks;
+    report("schedule line, snprintf", nowNs() - start, ticks, rounds * FEED_COUNT);
+    start = nowNs();
+    ticks = readTicks();
+    for (r = 0; r < rounds; r++)
+        for (i = 0; i < TIME_COUNT; i++)
+            sink += formatTimeLine(line, times[i]) - line;
+    ticks = readTicks() - ticks;
+    report("time line, format.c", nowNs() - start, ticks, rounds * TIME_COUNT);
+    start = nowNs();
+    ticks = readTicks();
+    for (r = 0; r < rounds; r++)
+        for (i = 0; i < TIME_COUNT; i++)
+            sink += printTimeLine(line, times[i]);
+    ticks = readTicks() - ticks;
+    report("time line, snprintf", nowNs() - start, ticks, rounds * TIME_COUNT);
+    return failed ? 1 : 0;
+}
+
+#endif
@@ -0,0 +1,224 @@
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target uC:       host (POSIX)
+// System Clock:    -
+
+// Config load commit of layout.c on the EEPROM model
+//   loads snapshot B over snapshot A, B changing feedings, a date range and the config, and cuts the
+//   power at every EEPROM word, flash word and flash page erase the load programs, in a child process;
+//   the next boot must pass validateLayout unchanged and export exactly A or exactly B, A until the
+//   staged load is marked and B from then on
+//   then the same for a snapshot using every slot loaded onto an empty schedule, and for a command
+//   batch editing feedings of A, committed at its end
+// usage: importtest, EEPROM_IMAGE and FLASH_IMAGE name the images (erased first)
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "calendar.h"
+#include "eeprom.h"
+#include "eepromhost.h"
+#include "flashhost.h"
+#include "layout.h"
+#include "packet.h"
+#include "schedule.h"
+
+#define EEPROM_WORDS        512
+#define FIRST_FEEDS         20          // feedings of A
+#define BATCH_FEEDS         10          // feedings a command batch edits
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+uint32_t first[SNAPSHOT_MAX_WORDS], second[SNAPSHOT_MAX_WORDS], empty[SNAPSHOT_MAX_WORDS];
+uint32_t full[SNAPSHOT_MAX_WORDS], target[SNAPSHOT_MAX_WORDS], current[SNAPSHOT_MAX_WORDS];
+uint32_t saved[EEPROM_WORDS];
+uint16_t firstLength, secondLength, fullLength;
+bool failed = false;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void check(bool ok, const char* what)
+{
+    if (!ok)
+    {
+        printf("importtest: FAILED %s\n", what);
+        failed = true;
+    }
+}
+
+// EEPROM words, flash words and flash pages programmed or erased, each a point a power cut can fall on
+uint32_t getSteps(void)
+{
+    uint32_t words, dataWords, flashWords, erases;
+    getEepromProgramCounts(&words, &dataWords);
+    getFlashCounts(&flashWords, &erases);
+    return words + flashWords + erases;
+}
+
+// empties the schedule, then writes count feedings from slot 0 every 7 minutes from hour, a date
+//  range on the first when ranged, and exports the snapshot with volume as its config
+uint16_t makeSnapshot(uint32_t* snapshot, uint16_t count, uint8_t hour, bool ranged, uint32_t volume)
+{
+    FEED_SLOT feed;
+    uint16_t slot, length;
+    for (slot = 0; slot < MAX_SLOTS; slot++)
+        clearFeedSlot(slot);
+    for (slot = 0; slot < count; slot++)
+    {
+        feed.flag = slot;
+        feed.duration = 1 + slot % MAX_DURATION;
+        feed.pwm = 60 + slot % 40;
+        feed.hour = (hour + slot * 7 / 60) % 24;
+        feed.minute = slot * 7 % 60;
+        feed.days = slot % 3 ? ALL_DAYS : 0x3E;
+        feed.firstDay = ranged && slot == 0 ? 20744 : 0;
+        feed.lastDay = ranged && slot == 0 ? 20800 : NO_LAST_DAY;
+        writeFeedSlot(slot, &feed);
+    }
+    length = exportSnapshot(snapshot);
+    snapshot[SNAPSHOT_CONFIG] = volume;
+    snapshot[length - 1] = crc32(0, (const uint8_t*)snapshot, (length - 1) * 4);
+    return length;
+}
+
+// boots as the firmware does and compares what it exports with snapshot, the regions must all pass
+bool bootsTo(const uint32_t* snapshot, uint16_t length)
+{
+    initLayout();
+    if (validateLayout() != 0)
+        return false;
+    loadSchedule();
+    return exportSnapshot(current) == length && memcmp(current, snapshot, length * 4) == 0;
+}
+
+// the changes swept by sweepPowerCuts, from the old snapshot as loaded and booted
+void loadSecond(void)
+{
+    importSnapshot(second, secondLength);
+}
+
+void loadFull(void)
+{
+    importSnapshot(full, fullLength);
+}
+
+// a command line editing BATCH_FEEDS feedings, one of them getting a date range, as processLine runs it
+void editBatch(void)
+{
+    FEED_SLOT feed;
+    uint16_t slot;
+    deferFeedWrites();
+    for (slot = 0; slot < BATCH_FEEDS; slot++)
+    {
+        getFeedSlot(slot, &feed);
+        feed.minute = (feed.minute + 1) % 60;
+        feed.firstDay = slot == 3 ? 20750 : 0;
+        feed.lastDay = slot == 3 ? 20760 : NO_LAST_DAY;
+        writeFeedSlot(slot, &feed);
+    }
+    commitFeedWrites();
+}
+
+// makes change over from, then the same change cut short after every number of programmed words, flash
+//  words and page erases, the next boot must give from until some cut and what the change gave from
+//  then on, returns the number of steps
+uint32_t sweepPowerCuts(const uint32_t* from, uint16_t fromLength, void (*change)(void))
+{
+    uint32_t steps, cut, froms = 0, tos = 0;
+    uint16_t toLength;
+    int status;
+    pid_t child;
+    check(importSnapshot(from, fromLength) == IMPORT_DONE && bootsTo(from, fromLength), "loading the old snapshot");
+    readEepromBlock(0, saved, EEPROM_WORDS);
+    steps = getSteps();
+    change();
+    steps = getSteps() - steps;
+    initLayout();
+    check(validateLayout() == 0, "the regions after the change");
+    loadSchedule();
+    toLength = exportSnapshot(target);
+    for (cut = 0; cut < steps && !failed; cut++)
+    {
+        writeEepromBlock(0, saved, EEPROM_WORDS);
+        loadSchedule();
+        fflush(stdout);
+        child = fork();
+        if (child == 0)
+        {
+            setEepromPowerLoss(cut);
+            change();
+            _exit(0);
+        }
+        waitpid(child, &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != EEPROM_POWER_LOST)
+        {
+            printf("importtest: FAILED power cut after %u steps, the change ended with status %d\n", cut, status);
+            failed = true;
+            break;
+        }
+        if (bootsTo(from, fromLength))
+        {
+            check(tos == 0, "the old snapshot after a cut later than one that gave the new one");
+            froms++;
+        }
+        else if (bootsTo(target, toLength))
+            tos++;
+        else
+            check(false, "a power cut left a mix of the old and the new snapshot");
+    }
+    printf("importtest: power cut at each of %u steps, %u booted to the old snapshot and %u to the new%s\n",
+           cut, froms, tos, failed ? ", FAILED" : "");
+    return steps;
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t before, steps;
+
+    initEeprom();
+    eraseEepromImage();
+    eraseFlashImage();
+    initLayout();
+    validateLayout();
+    loadSchedule();
+
+    // B moves every feeding of A by an hour and adds a date range and a volume
+    firstLength = makeSnapshot(first, FIRST_FEEDS, 6, false, 250);
+    secondLength = makeSnapshot(second, FIRST_FEEDS, 7, true, 400);
+    check(importSnapshot(first, firstLength) == IMPORT_DONE && bootsTo(first, firstLength), "loading A");
+    memcpy(current, second, secondLength * 4);
+    current[SNAPSHOT_FEEDS + 1] ^= 1;   // the crc no longer matches
+    before = getSteps();
+    check(importSnapshot(current, secondLength) == IMPORT_INVALID, "a snapshot with a bad crc refused");
+    check(getSteps() == before && bootsTo(first, firstLength), "a refused snapshot changed the EEPROM or flash");
+
+    steps = sweepPowerCuts(first, firstLength, loadSecond);
+    check(bootsTo(second, secondLength), "loading B");
+    printf("importtest: loading B over A takes %u steps\n", steps);
+
+    // every slot used, onto an empty schedule, in one load
+    makeSnapshot(empty, 0, 0, false, 300);
+    fullLength = makeSnapshot(full, MAX_SLOTS, 0, false, 300);
+    steps = sweepPowerCuts(empty, getSnapshotLength(empty), loadFull);
+    check(bootsTo(full, fullLength), "loading every slot");
+    printf("importtest: loading %u feedings onto an empty schedule takes %u steps\n", MAX_SLOTS, steps);
+
+    // a batch of feed commands over A
+    steps = sweepPowerCuts(first, firstLength, editBatch);
+    printf("importtest: a batch editing %u feedings takes %u steps%s\n", BATCH_FEEDS, steps,
+           failed ? ", FAILED" : "");
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,372 @@
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target uC:       TM4C123GH6PM
+// System Clock:    -
+
+// EEPROM layout detection and migration of the legacy layout, see layout.h for the current map
+//
+// Legacy layout (no layout word): feed slot i in words 16*i+0..4 (flag, duration, pwm, hour, minute),
+//   volume, fill mode and alert in words 5, 6, 7, visit log in words 16*1+6..11
+//
+// The migration first copies the blocks holding the old data to the flash staging pages and marks
+//   EE_MIGRATION, then writes the new layout from that copy, seals the regions and writes the layout
+//   word last, so a reset part way through simply repeats the second step on the next boot
+//
+// Config and schedule regions carry a crc32 so corruption is caught on boot and only the damaged
+//   region falls back to defaults
+//
+// A config load stages the new regions in the flash staging pages, each word at its EEPROM address,
+//   and marks EE_MIGRATION, then copies them to the EEPROM and reseals the regions, a reset after the
+//   mark copies them again on the next boot, so the schedule, ranges and config are either all old or
+//   all new, whatever the load changes (the spare EEPROM blocks hold 64 words, a full schedule 256)
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "eeprom.h"
+#include "flash.h"
+#include "calendar.h"
+#include "packet.h"
+#include "layout.h"
+#include "schedule.h"
+#include "visitlog.h"
+
+#define MIGRATION_STAGED    0x4D494752  // "MIGR", legacy layout staged
+#define MIGRATION_IMPORT    0x4D494749  // "MIGI", config load staged in flash
+#define MIGRATION_DONE      0
+#define STAGED(add)         (FLASH_STAGE + 4*(add))     // flash copy of EEPROM word add
+
+// Legacy layout
+#define LEGACY_SLOTS        10
+#define LEGACY_WORDS        (16*LEGACY_SLOTS)  // blocks holding the legacy data, slot i in block i
+#define LEGACY_VOLUME       5
+#define LEGACY_FILL_MODE    6
+#define LEGACY_ALERT        7
+#define LEGACY_LOG          (16*1+6)
+#define LEGACY_LOG_SIZE     6
+
+typedef struct _REGION
+{
+    uint16_t address;
+    uint16_t size;                      // words
+    uint16_t crc;                       // crc word, the pending crc word follows it
+    uint32_t fill;                      // default value of every word
+} REGION;
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+const REGION regions[REGION_COUNT] =
+{
+    {EE_VOLUME,   3,            EE_CONFIG_CRC,   0},
+    {EE_SCHEDULE, MAX_SLOTS,    EE_SCHEDULE_CRC, SLOT_EMPTY},
+    {EE_RANGES,   2*MAX_RANGES, EE_RANGES_CRC,   RANGE_FREE},
+};
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+// Writes value to count words from add, one burst per block
+void fillEeprom(uint16_t add, uint32_t value, uint16_t count)
+{
+    uint32_t words[16];
+    uint16_t n;
+    for (n = 0; n < 16; n++)
+        words[n] = value;
+    for (; count != 0; count -= n, add += n)
+    {
+        n = count < 16 ? count : 16;
+        writeEepromBlock(add, words, n);
+    }
+}
+
+// Calculates the crc of a region as stored, reading it in bursts of one block
+uint32_t readRegionCrc(const REGION* region)
+{
+    uint32_t words[16];
+    uint32_t crc = 0;
+    uint16_t done, n;
+    for (done = 0; done < region->size; done += n)
+    {
+        n = region->size - done < 16 ? region->size - done : 16;
+        readEepromBlock(region->address + done, words, n);
+        crc = crc32(crc, (const uint8_t*)words, n * 4);
+    }
+    return crc;
+}
+
+// Stores the crc of a region in both crc words
+void sealRegion(const REGION* region)
+{
+    uint32_t crc = readRegionCrc(region);
+    writeEeprom(region->crc + 1, crc);
+    writeEeprom(region->crc, crc);
+}
+
+// Writes the defaults of a region and seals it
+void resetRegion(const REGION* region)
+{
+    fillEeprom(region->address, region->fill, region->size);
+    sealRegion(region);
+}
+
+// Checks every region against its crc words and restores defaults in the ones that fail, call after
+//  initLayout() and before the regions are read, returns a bit per restored region
+uint8_t validateLayout(void)
+{
+    uint32_t crcs[2];
+    uint32_t crc;
+    uint8_t i, restored = 0;
+    for (i = 0; i < REGION_COUNT; i++)
+    {
+        crc = readRegionCrc(&regions[i]);
+        readEepromBlock(regions[i].crc, crcs, 2);
+        if (crc != crcs[0] && crc != crcs[1])
+        {
+            resetRegion(&regions[i]);
+            restored |= 1 << i;
+        }
+    }
+    return restored;
+}
+
+// Writes one word of a region, contents is the whole region in RAM with the new value already in place
+//  the crc of the new contents goes to the pending crc word first, so a reset at any point leaves
+//  the region matching one of the two crc words
+void writeRegionWord(uint8_t region, const uint32_t* contents, uint16_t add)
+{
+    uint32_t crc = crc32(0, (const uint8_t*)contents, regions[region].size * 4);
+    writeEeprom(regions[region].crc + 1, crc);
+    writeEeprom(add, contents[add - regions[region].address]);
+    writeEeprom(regions[region].crc, crc);
+}
+
+// Fills snapshot with the config, the used slots and the date ranges of the RAM schedule, returns its
+//  length in words
+uint16_t exportSnapshot(uint32_t* snapshot)
+{
+    FEED_SLOT feed;
+    uint32_t range;
+    uint16_t slot, n = SNAPSHOT_FEEDS, ranges = 0;
+    snapshot[SNAPSHOT_HEADER] = SNAPSHOT_MAGIC | SNAPSHOT_VERSION;
+    readEepromBlock(EE_VOLUME, &snapshot[SNAPSHOT_CONFIG], 3);
+    for (slot = 0; slot < MAX_SLOTS; slot++)
+        if (isFeedSlotUsed(slot))
+        {
+            snapshot[n++] = slot;
+            snapshot[n++] = getFeedWord(slot);
+        }
+    snapshot[SNAPSHOT_COUNT] = (n - SNAPSHOT_FEEDS) / 2;
+    for (slot = 0; slot < MAX_SLOTS; slot++)
+    {
+        getFeedSlot(slot, &feed);
+        range = packFeedRange(&feed);
+        if (feed.flag != SLOT_FREE && range != RANGE_NONE)
+        {
+            snapshot[n++] = slot;
+            snapshot[n++] = range;
+            ranges++;
+        }
+    }
+    snapshot[SNAPSHOT_RANGES] = ranges;
+    snapshot[n] = crc32(0, (const uint8_t*)snapshot, n * 4);
+    return n + 1;
+}
+
+// Length in words of a snapshot from its counts, needs the words up to SNAPSHOT_RANGES, 0 if the
+//  counts are out of range
+uint16_t getSnapshotLength(const uint32_t* snapshot)
+{
+    if (snapshot[SNAPSHOT_COUNT] > MAX_SLOTS || snapshot[SNAPSHOT_RANGES] > MAX_RANGES)
+        return 0;
+    return SNAPSHOT_FEEDS + 2*snapshot[SNAPSHOT_COUNT] + 2*snapshot[SNAPSHOT_RANGES] + 1;
+}
+
+// Erases the flash staging pages
+void eraseStage(void)
+{
+    uint8_t i;
+    for (i = 0; i < FLASH_STAGE_PAGES; i++)
+        eraseFlashPage(FLASH_STAGE + i*FLASH_PAGE_SIZE);
+}
+
+// Copies the staged words of every region from flash to the EEPROM and reseals the regions, repeating
+//  it after a reset writes the same words again, unchanged words are not programmed
+void commitStage(void)
+{
+    uint32_t words[16];
+    uint16_t done, n;
+    uint8_t i;
+    for (i = 0; i < REGION_COUNT; i++)
+    {
+        for (done = 0; done < regions[i].size; done += n)
+        {
+            n = regions[i].size - done < 16 ? regions[i].size - done : 16;
+            readFlash(STAGED(regions[i].address + done), words, n);
+            writeEepromBlock(regions[i].address + done, words, n);
+        }
+        sealRegion(&regions[i]);
+    }
+    writeEeprom(EE_MIGRATION, MIGRATION_DONE);
+}
+
+// Stores the schedule and date range regions from RAM at once, staged in flash as a config load is,
+//  so a reset part way through leaves all the old words or completes the new ones on the next boot
+void commitSchedule(const uint32_t* slots, const uint32_t* ranges)
+{
+    uint32_t config[3];
+    readEepromBlock(EE_VOLUME, config, 3);
+    eraseStage();
+    programFlash(STAGED(EE_VOLUME), config, 3);
+    programFlash(STAGED(EE_SCHEDULE), slots, MAX_SLOTS);
+    programFlash(STAGED(EE_RANGES), ranges, 2*MAX_RANGES);
+    writeEeprom(EE_MIGRATION, MIGRATION_IMPORT);
+    commitStage();
+}
+
+// Builds the packed words of the 16 slots from first, *entry is the next snapshot entry to use
+void getSnapshotBlock(const uint32_t* snapshot, uint16_t* entry, uint16_t first, uint32_t* words)
+{
+    const uint32_t* feeds = &snapshot[SNAPSHOT_FEEDS];
+    uint8_t i;
+    for (i = 0; i < 16; i++)
+    {
+        words[i] = SLOT_EMPTY;
+        if (*entry < snapshot[SNAPSHOT_COUNT] && feeds[2 * *entry] == first + i)
+        {
+            words[i] = feeds[2 * *entry + 1];
+            (*entry)++;
+        }
+    }
+}
+
+// Checks a snapshot and stores it, returns IMPORT_INVALID and leaves the EEPROM untouched if it is not
+//  valid: every entry must be exactly what packFeedSlot() and packFeedRange() produce, in increasing
+//  slot order, and a date range needs its slot, so out of range fields and repeated slots are refused
+//  the new regions are staged in flash first, so a reset part way through leaves the old contents or
+//  completes the new ones on the next boot, the caller reloads the RAM copies afterwards
+uint8_t importSnapshot(const uint32_t* snapshot, uint16_t length)
+{
+    const uint32_t* feeds = &snapshot[SNAPSHOT_FEEDS];
+    const uint32_t* ranges;
+    uint32_t words[16];                 // one block of slots, or the date range table
+    uint16_t i, entry = 0;
+    FEED_SLOT feed;
+    if (length <= SNAPSHOT_RANGES || snapshot[SNAPSHOT_HEADER] != (SNAPSHOT_MAGIC | SNAPSHOT_VERSION)
+            || length != getSnapshotLength(snapshot)
+            || snapshot[length - 1] != crc32(0, (const uint8_t*)snapshot, (length - 1) * 4))
+        return IMPORT_INVALID;
+    for (i = 0; i < snapshot[SNAPSHOT_COUNT]; i++)
+    {
+        unpackFeedSlot(feeds[2*i + 1], feeds[2*i], &feed);
+        if (feeds[2*i] >= MAX_SLOTS || feed.flag == SLOT_FREE || packFeedSlot(&feed) != feeds[2*i + 1]
+                || (i != 0 && feeds[2*i] <= feeds[2*i - 2]))
+            return IMPORT_INVALID;
+    }
+    ranges = &feeds[2*snapshot[SNAPSHOT_COUNT]];
+    for (i = 0; i < snapshot[SNAPSHOT_RANGES]; i++)
+    {
+        while (entry < snapshot[SNAPSHOT_COUNT] && feeds[2*entry] < ranges[2*i])
+            entry++;
+        feed.firstDay = ranges[2*i + 1] & 0xFFFF;
+        feed.lastDay = ranges[2*i + 1] >> 16;
+        if (entry == snapshot[SNAPSHOT_COUNT] || feeds[2*entry] != ranges[2*i]
+                || packFeedRange(&feed) != ranges[2*i + 1] || ranges[2*i + 1] == RANGE_NONE
+                || feed.firstDay > feed.lastDay || feed.firstDay > LAST_DAY)
+            return IMPORT_INVALID;
+        entry++;
+    }
+    if (snapshot[SNAPSHOT_CONFIG + 1] > 1 || snapshot[SNAPSHOT_CONFIG + 2] > 1)    // fill mode, alert
+        return IMPORT_INVALID;
+
+    entry = 0;
+    eraseStage();
+    programFlash(STAGED(EE_VOLUME), &snapshot[SNAPSHOT_CONFIG], 3);
+    for (i = 0; i < MAX_SLOTS; i += 16)
+    {
+        getSnapshotBlock(snapshot, &entry, i, words);
+        programFlash(STAGED(EE_SCHEDULE + i), words, 16);
+    }
+    for (i = 0; i < 2*MAX_RANGES; i++)
+        words[i] = i < 2*snapshot[SNAPSHOT_RANGES] ? ranges[i] : RANGE_FREE;
+    programFlash(STAGED(EE_RANGES), words, 2*MAX_RANGES);
+    writeEeprom(EE_MIGRATION, MIGRATION_IMPORT);
+    commitStage();
+    return IMPORT_DONE;
+}
+
+// Copies the blocks the legacy layout holds to the flash staging pages
+void stageLegacyLayout(void)
+{
+    uint32_t words[16];
+    uint16_t add;
+    eraseStage();
+    for (add = 0; add < LEGACY_WORDS; add += 16)
+    {
+        readEepromBlock(add, words, 16);
+        programFlash(STAGED(add), words, 16);
+    }
+    writeEeprom(EE_MIGRATION, MIGRATION_STAGED);
+}
+
+// Writes the current layout from the staged legacy copy, a slot is used when its flag word is below
+//  LEGACY_SLOTS as the legacy firmware tested it
+void convertLegacyLayout(void)
+{
+    uint32_t legacy[5];                 // one slot: flag, duration, pwm, hour, minute
+    uint32_t words[LEGACY_SLOTS];
+    uint32_t config[3];
+    uint32_t log[LEGACY_LOG_SIZE];
+    FEED_SLOT feed;
+    uint8_t i;
+    for (i = 0; i < LEGACY_SLOTS; i++)
+    {
+        words[i] = SLOT_EMPTY;
+        readFlash(STAGED(16*i), legacy, 5);
+        if (legacy[0] >= LEGACY_SLOTS)  // deleted (flag 11) or never written
+            continue;
+        feed.flag = i;
+        feed.duration = legacy[1];
+        feed.pwm = legacy[2];
+        feed.hour = legacy[3];
+        feed.minute = legacy[4];
+        feed.days = ALL_DAYS;
+        words[i] = packFeedSlot(&feed);
+    }
+    readFlash(STAGED(LEGACY_VOLUME), config, 3);
+    for (i = 0; i < 3; i++)
+        if (config[i] == 0xFFFFFFFF)    // blank part, default config
+            config[i] = 0;
+    readFlash(STAGED(LEGACY_LOG), log, LEGACY_LOG_SIZE);
+    writeEepromBlock(EE_SCHEDULE, words, LEGACY_SLOTS);
+    fillEeprom(EE_SCHEDULE + LEGACY_SLOTS, SLOT_EMPTY, MAX_SLOTS - LEGACY_SLOTS);
+    fillEeprom(EE_RANGES, RANGE_FREE, 2*MAX_RANGES);
+    writeEepromBlock(EE_VOLUME, config, 3);
+    formatVisitLog(log, LEGACY_LOG_SIZE);
+    for (i = 0; i < REGION_COUNT; i++)
+        sealRegion(&regions[i]);
+    writeEeprom(EE_LAYOUT, LAYOUT_MAGIC | LAYOUT_VERSION);
+    writeEeprom(EE_MIGRATION, MIGRATION_DONE);
+}
+
+// Brings the EEPROM to the current layout, call once after initEeprom() and before anything reads it
+void initLayout(void)
+{
+    uint32_t migration = readEeprom(EE_MIGRATION);
+    if (migration == MIGRATION_STAGED)          // interrupted migration, staged copy is complete
+        convertLegacyLayout();
+    else if (migration == MIGRATION_IMPORT)     // interrupted config load, staged regions are complete
+        commitStage();
+    else if ((readEeprom(EE_LAYOUT) & 0xFFFFFF00) != LAYOUT_MAGIC)
+    {
+        stageLegacyLayout();
+        convertLegacyLayout();
+    }
+}
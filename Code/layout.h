@@ -0,0 +1,74 @@
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target uC:       TM4C123GH6PM
+// System Clock:    -
+
+#ifndef LAYOUT_H_
+#define LAYOUT_H_
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+// EEPROM word addresses (2 KB = 32 blocks of 16 words)
+//   block 0:   layout word, configuration, region checksums and the last feeding run
+//   block 1-16: feed slots, one packed word each
+//   block 17:  date ranges of feedings, see schedule.c
+//   block 18-31: visit log, see visitlog.c
+// The legacy data while it is migrated and a config load are staged in flash, see flash.h
+#define LAYOUT_MAGIC        0x46454400  // "FED" in the upper 3 bytes, version in the low byte
+#define LAYOUT_VERSION      6           // the legacy layout is converted by initLayout()
+
+#define EE_LAYOUT           0           // LAYOUT_MAGIC | LAYOUT_VERSION
+#define EE_VOLUME           1           // volume, fill mode and alert are read together
+#define EE_FILL_MODE        2
+#define EE_ALERT            3
+#define EE_CONFIG_CRC       4           // crc32 of the config region, the next word holds the crc of
+                                        //   the values being written (see writeRegionWord)
+#define EE_SCHEDULE_CRC     6
+#define EE_RANGES_CRC       8
+#define EE_LAST_FEED        10          // RTC seconds of the last feeding run, erased before the first one
+#define EE_CATCHUP          11          // missed feeding policy, erased or invalid reads as the default
+#define EE_MIGRATION        15          // set while converting the legacy layout or committing a config load
+#define EE_SCHEDULE         16
+#define EE_RANGES           (16*17)
+#define EE_LOG              (16*18)
+#define LOG_BLOCKS          14
+
+// Checksummed regions
+#define REGION_CONFIG       0           // volume, fill mode, alert, defaults 0
+#define REGION_SCHEDULE     1           // feed slots, defaults free
+#define REGION_RANGES       2           // date range table, defaults free
+#define REGION_COUNT        3
+
+// Configuration snapshot for config dump / config load, sent as little endian words
+//   the used slots follow in slot order as two words each, slot number and packed word, then the date
+//   ranges in slot order as slot number and packed range, then the crc32 of every word before it
+#define SNAPSHOT_MAGIC      0x46434600  // "FCF" in the upper 3 bytes, version in the low byte
+#define SNAPSHOT_VERSION    3
+#define SNAPSHOT_HEADER     0           // SNAPSHOT_MAGIC | SNAPSHOT_VERSION
+#define SNAPSHOT_CONFIG     1           // volume, fill mode, alert
+#define SNAPSHOT_COUNT      4           // used slots
+#define SNAPSHOT_RANGES     5           // date ranges
+#define SNAPSHOT_FEEDS      6
+#define SNAPSHOT_MAX_WORDS  (SNAPSHOT_FEEDS + 2*MAX_SLOTS + 2*MAX_RANGES + 1)
+
+// importSnapshot results
+#define IMPORT_DONE         0
+#define IMPORT_INVALID      1           // snapshot refused, nothing changed
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void initLayout(void);
+uint8_t validateLayout(void);
+void writeRegionWord(uint8_t region, const uint32_t* contents, uint16_t add);
+void commitSchedule(const uint32_t* slots, const uint32_t* ranges);
+uint16_t exportSnapshot(uint32_t* snapshot);
+uint16_t getSnapshotLength(const uint32_t* snapshot);
+uint8_t importSnapshot(const uint32_t* snapshot, uint16_t length);
+
+#endif
@@ -0,0 +1,179 @@
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target uC:       host (POSIX)
+// System Clock:    -
+
+// Legacy layout migration of layout.c on the EEPROM model
+//   writes a legacy image as the original firmware left it: used slots (flag = slot number), slots
+//   deleted by "feed i delete" (flag 11, all fields 0), slots never written (erased), the config words
+//   and the 6 visit ring, boots it and checks the schedule, config and visit log that come out
+//   a deleted or erased legacy slot must stay free, not become a feeding at 00:00
+//   then cuts the power at every EEPROM word, flash word and flash page erase the migration programs,
+//   in a child process, and checks the next boot finishes the migration with the same result
+// usage: migrationtest, EEPROM_IMAGE and FLASH_IMAGE name the images (erased first)
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "calendar.h"
+#include "eeprom.h"
+#include "eepromhost.h"
+#include "flashhost.h"
+#include "layout.h"
+#include "schedule.h"
+#include "visitlog.h"
+
+#define LEGACY_DELETED      11          // flag the legacy feed delete wrote
+#define LEGACY_ERASED       0xFFFFFFFF
+#define LEGACY_LOG          (16*1+6)
+
+// one legacy slot: flag, duration, pwm, hour, minute
+typedef struct _LEGACY_SLOT
+{
+    uint32_t words[5];
+} LEGACY_SLOT;
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+const LEGACY_SLOT legacySlots[10] =
+{
+    {{0, 5, 80, 7, 30}},
+    {{LEGACY_DELETED, 0, 0, 0, 0}},
+    {{2, 8, 60, 12, 0}},
+    {{LEGACY_ERASED, LEGACY_ERASED, LEGACY_ERASED, LEGACY_ERASED, LEGACY_ERASED}},
+    {{LEGACY_DELETED, 0, 0, 0, 0}},
+    {{5, 10, 100, 18, 45}},
+    {{LEGACY_DELETED, 0, 0, 0, 0}},
+    {{LEGACY_ERASED, LEGACY_ERASED, LEGACY_ERASED, LEGACY_ERASED, LEGACY_ERASED}},
+    {{8, 3, 50, 23, 59}},
+    {{LEGACY_DELETED, 0, 0, 0, 0}},
+};
+const uint32_t legacyConfig[3] = {350, 1, 0};   // volume, fill mode, alert
+const uint32_t legacyVisits[6] = {1792195200, 1792198800, 1792202400, 1792206000, LEGACY_ERASED, LEGACY_ERASED};
+#define USED_SLOTS 4
+#define LOGGED_VISITS 4
+
+bool failed = false;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void check(bool ok, const char* what)
+{
+    if (!ok)
+    {
+        printf("migrationtest: FAILED %s\n", what);
+        failed = true;
+    }
+}
+
+void writeLegacyImage(void)
+{
+    uint8_t i;
+    eraseEepromImage();
+    for (i = 0; i < 10; i++)
+        if (legacySlots[i].words[0] != LEGACY_ERASED)
+            writeEepromBlock(16*i, legacySlots[i].words, 5);
+    writeEepromBlock(5, legacyConfig, 3);
+    writeEepromBlock(LEGACY_LOG, legacyVisits, 6);
+}
+
+// boots as the firmware does and checks what the migration produced, returns false on the first
+//  difference so the power loss sweep reports the cut that caused it
+bool checkMigrated(const char* when)
+{
+    uint32_t visits[LOGGED_VISITS];
+    FEED_SLOT feed;
+    uint16_t slot, used = 0;
+    bool ok = true;
+    initLayout();
+    ok &= validateLayout() == 0;
+    loadSchedule();
+    initVisitLog();
+    ok &= readEeprom(EE_LAYOUT) == (LAYOUT_MAGIC | LAYOUT_VERSION);
+    for (slot = 0; slot < MAX_SLOTS; slot++)
+    {
+        getFeedSlot(slot, &feed);
+        if (slot < 10 && legacySlots[slot].words[0] == slot)
+        {
+            ok &= feed.flag == slot && feed.duration == legacySlots[slot].words[1]
+                    && feed.pwm == legacySlots[slot].words[2] && feed.hour == legacySlots[slot].words[3]
+                    && feed.minute == legacySlots[slot].words[4] && feed.days == ALL_DAYS
+                    && feed.firstDay == 0 && feed.lastDay == NO_LAST_DAY;
+            used++;
+        }
+        else
+            ok &= feed.flag == SLOT_FREE && getFeedWord(slot) == SLOT_EMPTY;
+    }
+    ok &= used == USED_SLOTS && getFeedCount() == USED_SLOTS;
+    ok &= readEeprom(EE_VOLUME) == legacyConfig[0] && readEeprom(EE_FILL_MODE) == legacyConfig[1]
+            && readEeprom(EE_ALERT) == legacyConfig[2];
+    ok &= getVisitCount() == LOGGED_VISITS && readVisits(0, visits, LOGGED_VISITS) == LOGGED_VISITS;
+    for (slot = 0; slot < LOGGED_VISITS && ok; slot++)
+        ok &= visits[slot] == legacyVisits[LOGGED_VISITS - 1 - slot];    // newest first
+    if (!ok)
+        check(false, when);
+    return ok;
+}
+
+// EEPROM words, flash words and flash pages programmed or erased, each a point a power cut can fall on
+uint32_t getSteps(void)
+{
+    uint32_t words, dataWords, flashWords, erases;
+    getEepromProgramCounts(&words, &dataWords);
+    getFlashCounts(&flashWords, &erases);
+    return words + flashWords + erases;
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t steps, cut;
+    int status;
+    pid_t child;
+
+    initEeprom();
+    eraseFlashImage();
+    writeLegacyImage();
+    steps = getSteps();
+    initLayout();
+    steps = getSteps() - steps;
+    checkMigrated("legacy migration");
+    printf("migrationtest: legacy image with %u of 10 slots used migrated in %u steps\n", USED_SLOTS, steps);
+
+    // the same migration cut short after every number of steps
+    for (cut = 0; cut < steps && !failed; cut++)
+    {
+        writeLegacyImage();
+        fflush(stdout);
+        child = fork();
+        if (child == 0)
+        {
+            setEepromPowerLoss(cut);
+            initLayout();
+            _exit(0);
+        }
+        waitpid(child, &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != EEPROM_POWER_LOST)
+        {
+            printf("migrationtest: FAILED power cut after %u steps, boot ended with status %d\n", cut, status);
+            failed = true;
+            break;
+        }
+        if (!checkMigrated("migration after a power cut"))
+            printf("migrationtest: the power was cut after %u steps\n", cut);
+    }
+    printf("migrationtest: power cut at each of %u steps%s\n", cut, failed ? ", FAILED" : ", all finished on the next boot");
+    return failed ? 1 : 0;
+}
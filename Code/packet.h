@@ -0,0 +1,44 @@
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target uC:       TM4C123GH6PM
+// System Clock:    -
+
+#ifndef PACKET_H_
+#define PACKET_H_
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+// Packet layout (before framing): request id, opcode, payload..., crc16 (little endian)
+//   replies echo the request id and set bit 7 of the opcode, first payload byte is a status
+#define PACKET_DELIMITER    0x00
+#define PACKET_HEADER_SIZE  2
+#define PACKET_CRC_SIZE     2
+#define PACKET_MAX_SIZE     128
+#define FRAME_MAX_SIZE      (PACKET_MAX_SIZE + PACKET_MAX_SIZE/254 + 2)
+
+#define PACKET_REPLY        0x80
+
+// Receive side of a stream of frames, see receiveFrameByte
+typedef struct _FRAME_RX
+{
+    uint8_t frame[FRAME_MAX_SIZE];      // delimiter not stored
+    uint16_t count;                     // bytes since the last delimiter, may pass FRAME_MAX_SIZE
+} FRAME_RX;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+uint16_t crc16(const uint8_t* data, uint16_t length);
+uint32_t crc32(uint32_t crc, const uint8_t* data, uint16_t length);
+uint16_t cobsEncode(const uint8_t* in, uint16_t length, uint8_t* out);
+uint16_t cobsDecode(const uint8_t* in, uint16_t length, uint8_t* out);
+uint16_t encodePacket(uint8_t* packet, uint16_t length, uint8_t* frame);
+uint16_t decodePacket(const uint8_t* frame, uint16_t length, uint8_t* packet);
+uint16_t receiveFrameByte(FRAME_RX* rx, uint8_t c, uint8_t* packet);
+
+#endif
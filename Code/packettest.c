@@ -0,0 +1,376 @@
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target uC:       host (POSIX)
+// System Clock:    -
+
+// Round trips of the binary protocol over the UART0 model of uarthost.c, in real line time
+//   the host side encodes requests with packet.c and decodes the replies with receiveFrameByte,
+//   the device side runs the getPacketsUart0 loop of the firmware over uart0.c and answers
+//   OP_TIME_GET and OP_SCHEDULE with replies of the size processPacket sends, through putsUart0Dma
+//   reports round trips/s and bytes on the wire against the text commands that get the same answer,
+//   and the host cost of reading a full schedule reply against scanning the text schedule report
+//   then corrupts one request in four: the device must drop it, the host retries on its timeout
+//   any lost, duplicated or mismatched reply fails the run
+// usage: packettest [baud]
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "calendar.h"
+#include "format.h"
+#include "packet.h"
+#include "schedule.h"
+#include "uart0.h"
+#include "uarthost.h"
+
+#define OP_TIME_GET         0x02    // same opcodes and layout as the firmware
+#define OP_SCHEDULE         0x0A
+#define STATUS_OK           0
+#define SCHEDULE_PACKET_MAX 11
+
+#define ROUND_TRIPS         100     // of each request
+#define PARSE_ROUNDS        100000
+#define REPLY_TIMEOUT_NS    50000000
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+const FEED_SLOT feeds[SCHEDULE_PACKET_MAX] =
+{
+    {0, 7, 65, 6, 0, ALL_DAYS, 0, NO_LAST_DAY},
+    {1, 5, 80, 7, 30, WEEKDAYS, 0, NO_LAST_DAY},
+    {2, 10, 50, 9, 0, WEEKEND_DAYS, 20743, NO_LAST_DAY},
+    {3, 4, 60, 10, 15, ALL_DAYS, 0, NO_LAST_DAY},
+    {4, 6, 70, 12, 0, WEEKDAYS, 20807, 20821},
+    {5, 8, 75, 13, 45, ALL_DAYS, 0, NO_LAST_DAY},
+    {6, 3, 90, 15, 0, 0x22, 0, 20821},
+    {7, 12, 55, 17, 30, ALL_DAYS, 0, NO_LAST_DAY},
+    {8, 63, 100, 18, 30, 0x43, 20807, 20821},
+    {9, 5, 40, 20, 0, WEEKDAYS, 0, NO_LAST_DAY},
+    {10, 9, 85, 22, 45, ALL_DAYS, 0, NO_LAST_DAY},
+};
+const uint32_t now = 1792218567;        // 2026-10-17 06:29:27
+const uint32_t nextAlarm = 1792220400;
+
+char report[FRAME_MAX_SIZE];            // static, the uDMA model reaches it through a 32 bit address
+volatile bool reportBusy = false;
+FRAME_RX deviceRx, hostRx;
+uint32_t deviceRequests = 0;
+volatile uint32_t sink;
+bool failed = false;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+uint64_t nowNs(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec * 1000000000 + t.tv_nsec;
+}
+
+void check(bool ok, const char* what)
+{
+    if (!ok)
+    {
+        printf("packettest: FAILED %s\n", what);
+        failed = true;
+    }
+}
+
+uint8_t* putWord(uint8_t* p, uint32_t value)
+{
+    *p++ = value;
+    *p++ = value >> 8;
+    *p++ = value >> 16;
+    *p++ = value >> 24;
+    return p;
+}
+
+uint8_t* putHalf(uint8_t* p, uint16_t value)
+{
+    *p++ = value;
+    *p++ = value >> 8;
+    return p;
+}
+
+uint32_t getWord(const uint8_t* p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+uint16_t getHalf(const uint8_t* p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+void reportSent(void)
+{
+    reportBusy = false;
+}
+
+// the device: the answers processPacket gives to OP_TIME_GET and OP_SCHEDULE
+void answerPacket(uint8_t* packet, uint16_t length)
+{
+    uint8_t reply[PACKET_MAX_SIZE+PACKET_CRC_SIZE];
+    uint8_t* out = &reply[3];
+    uint8_t i;
+    reply[0] = packet[0];
+    reply[1] = packet[1] | PACKET_REPLY;
+    reply[2] = STATUS_OK;
+    if (packet[1] == OP_TIME_GET)
+        out = putWord(out, now);
+    else
+    {
+        out = putHalf(out, SCHEDULE_PACKET_MAX);
+        for (i = 0; i < SCHEDULE_PACKET_MAX; i++)
+        {
+            *out++ = feeds[i].flag;
+            *out++ = feeds[i].duration;
+            *out++ = feeds[i].pwm;
+            *out++ = feeds[i].hour;
+            *out++ = feeds[i].minute;
+            *out++ = feeds[i].days;
+            out = putHalf(out, feeds[i].firstDay);
+            out = putHalf(out, feeds[i].lastDay);
+        }
+        out = putWord(out, nextAlarm);
+    }
+    deviceRequests++;
+    while (reportBusy);
+    reportBusy = true;
+    while (!putsUart0Dma(report, encodePacket(reply, out - reply, (uint8_t*)report), reportSent));
+}
+
+// the device main loop pass, as getPacketsUart0
+void pollDevice(void)
+{
+    uint8_t packet[FRAME_MAX_SIZE];
+    uint16_t length;
+    while (kbhitUart0())
+    {
+        length = receiveFrameByte(&deviceRx, getcUart0(), packet);
+        if (length)
+            answerPacket(packet, length);
+    }
+}
+
+// reads a schedule reply as host automation would, returns false if it does not hold the feedings
+bool readScheduleReply(const uint8_t* packet, uint16_t length)
+{
+    uint16_t count, i;
+    const uint8_t* p = &packet[5];
+    uint32_t sum = 0;
+    if (length < 5 || packet[2] != STATUS_OK)
+        return false;
+    count = getHalf(&packet[3]);
+    if (length != 5 + 10*count + 4)
+        return false;
+    for (i = 0; i < count; i++, p += 10)
+    {
+        if (p[0] != feeds[i].flag || p[3] != feeds[i].hour || getHalf(&p[8]) != feeds[i].lastDay)
+            return false;
+        sum += p[1] + p[2] + p[4] + p[5] + getHalf(&p[6]);
+    }
+    sink += sum + getWord(p);
+    return getWord(p) == nextAlarm;
+}
+
+// sends one request, the device runs in the same loop, returns the reply length or 0 on timeout
+//   corrupt flips a bit of the request frame after its crc was computed
+uint16_t roundTrip(uint8_t id, uint8_t opcode, bool corrupt, uint8_t* reply, uint32_t* wireBytes)
+{
+    uint8_t request[PACKET_HEADER_SIZE+PACKET_CRC_SIZE], frame[FRAME_MAX_SIZE];
+    char received[64];
+    uint16_t length, frameLength;
+    uint32_t n, i;
+    uint64_t start = nowNs();
+    request[0] = id;
+    request[1] = opcode;
+    frameLength = encodePacket(request, PACKET_HEADER_SIZE, frame);
+    if (corrupt)
+        frame[1] ^= 0x10;
+    sendToUart0((char*)frame, frameLength);
+    *wireBytes += frameLength;
+    while (nowNs() - start < REPLY_TIMEOUT_NS)
+    {
+        pollDevice();
+        n = receiveFromUart0(received, sizeof(received));
+        for (i = 0; i < n; i++)
+        {
+            (*wireBytes)++;
+            length = receiveFrameByte(&hostRx, received[i], reply);
+            if (length)
+            {
+                check(i == n - 1, "bytes after the reply");
+                return length;
+            }
+        }
+    }
+    return 0;
+}
+
+// the text shell answers to time and schedule, built the way timeCommand and scheduleCommand do
+uint16_t makeTextReplies(char* timeLine, char* schedule)
+{
+    char* out = formatDate(timeLine, now/SECONDS_PER_DAY);
+    uint8_t i;
+    *out++ = ' ';
+    out = formatTime(out, now%SECONDS_PER_DAY, false);
+    *out++ = '\n';
+    *out = 0;
+    out = formatUnsigned(schedule, SCHEDULE_PACKET_MAX, 1);
+    out = formatString(out, " feedings, page 1 of 1\n");
+    for (i = 0; i < SCHEDULE_PACKET_MAX; i++)
+    {
+        out = formatUnsigned(out, feeds[i].flag, 1);
+        *out++ = '\t';
+        out = formatUnsigned(out, feeds[i].duration, 1);
+        *out++ = '\t';
+        out = formatUnsigned(out, feeds[i].pwm, 1);
+        *out++ = '\t';
+        out = formatUnsigned(out, feeds[i].hour, 2);
+        *out++ = ':';
+        out = formatUnsigned(out, feeds[i].minute, 2);
+        *out++ = '\t';
+        out = formatWeekdays(out, feeds[i].days);
+        if (feeds[i].firstDay != 0 || feeds[i].lastDay != NO_LAST_DAY)
+        {
+            *out++ = '\t';
+            if (feeds[i].firstDay != 0)
+                out = formatDate(out, feeds[i].firstDay);
+            out = formatString(out, " to ");
+            if (feeds[i].lastDay != NO_LAST_DAY)
+                out = formatDate(out, feeds[i].lastDay);
+        }
+        *out++ = '\n';
+    }
+    out = formatString(out, "next: ");
+    out = formatDate(out, nextAlarm/SECONDS_PER_DAY);
+    *out++ = ' ';
+    out = formatTime(out, nextAlarm%SECONDS_PER_DAY, false);
+    *out++ = '\n';
+    *out = 0;
+    return out - schedule;
+}
+
+// reads the text schedule report as host automation would, returns false if it does not hold the feedings
+bool readScheduleText(const char* text)
+{
+    unsigned count, flag, duration, pwm, hour, minute, year, month, day, i;
+    char days[8], rest[40];
+    int used;
+    uint32_t sum = 0;
+    if (sscanf(text, "%u feedings, page %*u of %*u\n%n", &count, &used) != 1)
+        return false;
+    text += used;
+    for (i = 0; i < count; i++)
+    {
+        if (sscanf(text, "%u\t%u\t%u\t%u:%u\t%7s%n", &flag, &duration, &pwm, &hour, &minute, days, &used) != 6)
+            return false;
+        text += used;
+        if (*text == '\t')
+        {
+            used = strcspn(text, "\n");
+            memcpy(rest, text, used < 40 ? used : 39);
+            rest[used < 40 ? used : 39] = 0;
+            if (sscanf(rest, "\t%u-%u-%u", &year, &month, &day) == 3)
+                sum += year + month + day;
+            text += used;
+        }
+        if (*text++ != '\n' || flag != feeds[i].flag || hour != feeds[i].hour)
+            return false;
+        sum += duration + pwm + minute + days[1];
+    }
+    if (sscanf(text, "next: %u-%u-%u %*s %u:%u", &year, &month, &day, &hour, &minute) != 5)
+        return false;
+    sink += sum + year + hour;
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    uint8_t reply[FRAME_MAX_SIZE], frame[FRAME_MAX_SIZE], packet[FRAME_MAX_SIZE];
+    char timeLine[32], schedule[1024];
+    uint32_t baud = 115200, trips, timeWire = 0, scheduleWire = 0, retries = 0, requests = 0, r;
+    uint16_t length, frameLength, textLength;
+    uint64_t start, timeNs, scheduleNs, binaryNs, textNs;
+    uint8_t id = 0;
+    UART_HOST_STATS host;
+
+    startUartHost(false);
+    initUart0();
+    if (argc > 1)
+        baud = setUart0BaudRate(strtoul(argv[1], 0, 10), 40000000);
+    printf("packettest: %u round trips of each request at %u baud\n", ROUND_TRIPS, baud);
+
+    start = nowNs();
+    for (trips = 0; trips < ROUND_TRIPS; trips++)
+    {
+        length = roundTrip(++id, OP_TIME_GET, false, reply, &timeWire);
+        check(length == 7 && reply[0] == id && reply[1] == (OP_TIME_GET | PACKET_REPLY) && getWord(&reply[3]) == now,
+              "time reply");
+    }
+    timeNs = nowNs() - start;
+    start = nowNs();
+    for (trips = 0; trips < ROUND_TRIPS; trips++)
+    {
+        length = roundTrip(++id, OP_SCHEDULE, false, reply, &scheduleWire);
+        check(reply[0] == id && reply[1] == (OP_SCHEDULE | PACKET_REPLY) && readScheduleReply(reply, length),
+              "schedule reply");
+    }
+    scheduleNs = nowNs() - start;
+    textLength = makeTextReplies(timeLine, schedule);
+    printf("time: %.0f round trips/s, %u bytes on the wire (text \"time\" %u)\n", ROUND_TRIPS / (timeNs / 1e9),
+           timeWire / ROUND_TRIPS, (unsigned)(5 + strlen(timeLine)));
+    printf("schedule: %.0f round trips/s, %u bytes on the wire for %u feedings (text \"schedule\" %u)\n",
+           ROUND_TRIPS / (scheduleNs / 1e9), scheduleWire / ROUND_TRIPS, SCHEDULE_PACKET_MAX, 9 + textLength);
+
+    // host side cost of reading the answer once it is in
+    length = roundTrip(++id, OP_SCHEDULE, false, reply, &scheduleWire);
+    reply[0] = id;
+    frameLength = encodePacket(reply, length, frame) - 1;
+    start = nowNs();
+    for (r = 0; r < PARSE_ROUNDS; r++)
+        check(readScheduleReply(packet, decodePacket(frame, frameLength, packet)), "schedule decode");
+    binaryNs = nowNs() - start;
+    start = nowNs();
+    for (r = 0; r < PARSE_ROUNDS; r++)
+        check(readScheduleText(schedule), "schedule text scan");
+    textNs = nowNs() - start;
+    printf("reading a schedule answer: decodePacket + fields %.0f ns, sscanf of the report %.0f ns\n",
+           (double)binaryNs / PARSE_ROUNDS, (double)textNs / PARSE_ROUNDS);
+
+    // one request in four corrupted on the line, retried with the same id
+    requests = deviceRequests;
+    for (trips = 0; trips < ROUND_TRIPS; trips++)
+    {
+        id++;
+        if (trips % 4 == 0)
+        {
+            check(roundTrip(id, OP_TIME_GET, true, reply, &timeWire) == 0, "corrupted request answered");
+            retries++;
+        }
+        length = roundTrip(id, OP_TIME_GET, false, reply, &timeWire);
+        check(length == 7 && reply[0] == id, "reply after retry");
+    }
+    check(deviceRequests - requests == ROUND_TRIPS, "requests answered once");
+    printf("corrupted requests: %u dropped by the device and retried\n", retries);
+
+    stopUartHost();
+    getUartHostStats(&host);
+    printf("packettest: %u bytes sent by uDMA, %u rx fifo overruns%s\n", host.dmaBytes, host.rxOverruns,
+           failed ? ", FAILED" : "");
+    return failed || host.rxOverruns ? 1 : 0;
+}
@@ -0,0 +1,271 @@
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target uC:       TM4C123GH6PM
+// System Clock:    -
+
+// Command line assembly and field parsing for the shell
+//   only buffer logic plus getcUart0/kbhitUart0, so it also builds on a host with a uart0 stub
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "uart0.h"
+#include "calendar.h"
+#include "parser.h"
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+// getsUart0NonBlocking assembles a line from whatever input is waiting in the uart0 rx ring
+//  accepts alphabet, 'ENTER', 'BACKSPACE', and numerical; returns true once 'ENTER' completes the line
+bool getsUart0NonBlocking(USER_DATA *data)
+{
+    char c;
+
+    while(kbhitUart0())
+    {
+        c = getcUart0();
+        if((c == 8 || c==127) && data->charCount>0)
+        {
+            data->charCount--;
+        }
+        else if(c == 13)
+        {
+            data->buffer[data->charCount] = 0;
+            data->charCount = 0;
+            return true;
+        }
+        else if(c >= 32)
+        {
+            data->buffer[data->charCount] = c;
+            data->charCount++;
+            if(data->charCount == MAX_CHARS)
+            {
+                data->buffer[data->charCount] = 0;
+                data->charCount = 0;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// getsUart0 gets input from PuTTY which only can be alphabet, 'ENTER', 'BACKSPACE', and numerical
+void getsUart0(USER_DATA *data)
+{
+    while(!getsUart0NonBlocking(data));
+}
+
+// keyword spellings, index is the KEYWORD_ value
+const char* keywords[] = {"", "delete", "auto", "motion", "on", "off", "dump", "load", "daily", "weekdays", "weekends",
+                          "run", "merge", "skip"};
+#define KEYWORD_COUNT (sizeof(keywords)/sizeof(keywords[0]))
+
+// returns the KEYWORD_ value of a word, compared without case, or KEYWORD_NONE
+uint8_t findKeyword(const char* word, uint8_t length)
+{
+    uint8_t k, i;
+    for(k = 1; k < KEYWORD_COUNT; k++)
+    {
+        for(i = 0; i < length && keywords[k][i] == (word[i] | 0x20); i++);
+        if(i == length && keywords[k][i] == 0)
+        {
+            return k;
+        }
+    }
+    return KEYWORD_NONE;
+}
+
+//  splits the buffer into typed fields in a single pass, putting null in every separator
+//      'n' number (value in fieldValue), 't' time of day H:MM or HH:MM (seconds since midnight in fieldValue),
+//      'y' date YYYY-MM-DD (day number, days since 1970-01-01, in fieldValue),
+//      'a' word (KEYWORD_ value in fieldValue), 'x' number that overflowed or is not a valid time or date
+void parseFields(USER_DATA *data)
+{
+    int bufferIndex = 0;
+    char type = 0;                      // type of the field being scanned, 0 between fields
+    uint32_t value = 0;
+    uint32_t hours = 0;
+    uint32_t year = 0, month = 0;
+    uint8_t minuteDigits = 0;
+    uint8_t dateParts = 0;              // dashes seen in a date
+    data->fieldCount = 0;
+    while(true)
+    {
+        char c = data->buffer[bufferIndex];
+        bool alpha = ((c >= 65) && (c <= 90)) || ((c >= 97) && (c <= 122));
+        bool digit = (c >= 48) && (c <= 57);
+
+        if(type == 0)
+        {
+            if(alpha || digit)
+            {
+                if(data->fieldCount == MAX_FIELDS)  // previous field is already terminated
+                {
+                    return;
+                }
+                data->fieldPosition[data->fieldCount] = bufferIndex;
+                type = digit ? 'n' : 'a';
+                value = digit ? c - 48 : 0;
+                dateParts = 0;
+            }
+            else if(c == 0)
+            {
+                return;
+            }
+            else
+            {
+                data->buffer[bufferIndex] = 0;
+            }
+        }
+        else if(digit && type == 'n')
+        {
+            if(value > (0xFFFFFFFF - (c - 48)) / 10)
+            {
+                type = 'x';
+            }
+            value = value*10 + (c - 48);
+        }
+        else if(c == ':' && type == 'n' && data->buffer[bufferIndex+1] >= 48 && data->buffer[bufferIndex+1] <= 57)
+        {
+            type = 't';
+            hours = value;
+            value = 0;
+            minuteDigits = 0;
+        }
+        else if(digit && type == 't')
+        {
+            value = value*10 + (c - 48);
+            if(++minuteDigits > 2)
+            {
+                type = 'x';
+            }
+        }
+        else if(c == '-' && (type == 'n' || (type == 'y' && dateParts == 1)) && data->buffer[bufferIndex+1] >= 48
+                && data->buffer[bufferIndex+1] <= 57)
+        {
+            if(type == 'n')
+            {
+                year = value;
+            }
+            else
+            {
+                month = value;
+            }
+            type = 'y';
+            dateParts++;
+            value = 0;
+            minuteDigits = 0;
+        }
+        else if(digit && type == 'y')
+        {
+            value = value*10 + (c - 48);
+            if(++minuteDigits > 2)
+            {
+                type = 'x';
+            }
+        }
+        else if((alpha || digit) && (type == 'a' || type == 'x'))
+        {
+        }
+        else if(alpha)
+        {
+            type = 'x';                 // letters inside a number
+        }
+        else
+        {
+            uint8_t field = data->fieldCount;
+            if(type == 't')
+            {
+                if(hours > 23 || value > 59)
+                {
+                    type = 'x';
+                }
+                value = hours*3600 + value*60;
+            }
+            else if(type == 'y')
+            {
+                if(dateParts != 2 || year < FIRST_YEAR || year > LAST_YEAR || month < 1 || month > 12
+                        || value < 1 || value > getMonthDays(year, month))
+                {
+                    type = 'x';
+                }
+                else
+                {
+                    value = daysFromCivil(year, month, value);
+                }
+            }
+            else if(type == 'a')
+            {
+                value = findKeyword(&data->buffer[data->fieldPosition[field]], bufferIndex - data->fieldPosition[field]);
+            }
+            data->fieldType[field] = type;
+            data->fieldValue[field] = value;
+            data->fieldCount++;
+            type = 0;
+            if(c == 0)
+            {
+                return;
+            }
+            data->buffer[bufferIndex] = 0;
+        }
+
+        bufferIndex++;
+    }
+}
+
+// checks if asked fieldNumber is alpha, if so returns it address
+char* getFieldString(USER_DATA* data, uint8_t fieldNumber)
+{
+    if((fieldNumber < data->fieldCount ) && (data->fieldType[fieldNumber] == 'a'))
+    {
+        return &(data->buffer[data->fieldPosition[fieldNumber]]);
+    }
+    return 0;
+}
+
+// checks if asked fieldNumber is numerical, if so returns the value converted by parseFields
+uint32_t getFieldInteger(USER_DATA* data, uint8_t fieldNumber)
+{
+    if((fieldNumber < data->fieldCount) && (data->fieldType[fieldNumber] == 'n'))
+    {
+        return data->fieldValue[fieldNumber];
+    }
+    return 0;
+}
+
+// checks if asked fieldNumber is a time of day, if so returns it in seconds since midnight
+uint32_t getFieldTime(USER_DATA* data, uint8_t fieldNumber)
+{
+    if((fieldNumber < data->fieldCount) && (data->fieldType[fieldNumber] == 't'))
+    {
+        return data->fieldValue[fieldNumber];
+    }
+    return 0;
+}
+
+// checks if asked fieldNumber is a word, if so returns its KEYWORD_ value (KEYWORD_NONE if not a keyword)
+uint8_t getFieldKeyword(USER_DATA* data, uint8_t fieldNumber)
+{
+    if((fieldNumber < data->fieldCount) && (data->fieldType[fieldNumber] == 'a'))
+    {
+        return data->fieldValue[fieldNumber];
+    }
+    return KEYWORD_NONE;
+}
+
+// checks if asked fieldNumber is a date, if so returns it as days since 1970-01-01
+uint32_t getFieldDate(USER_DATA* data, uint8_t fieldNumber)
+{
+    if((fieldNumber < data->fieldCount) && (data->fieldType[fieldNumber] == 'y'))
+    {
+        return data->fieldValue[fieldNumber];
+    }
+    return 0;
+}
@@ -0,0 +1,57 @@
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target uC:       TM4C123GH6PM
+// System Clock:    -
+
+#ifndef PARSER_H_
+#define PARSER_H_
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#define MAX_CHARS 240               // must stay below 256, fieldPosition is 8 bits
+#define MAX_FIELDS 8
+
+// keywords recognized by parseFields in word fields
+#define KEYWORD_NONE    0
+#define KEYWORD_DELETE  1
+#define KEYWORD_AUTO    2
+#define KEYWORD_MOTION  3
+#define KEYWORD_ON      4
+#define KEYWORD_OFF     5
+#define KEYWORD_DUMP    6
+#define KEYWORD_LOAD    7
+#define KEYWORD_DAILY   8
+#define KEYWORD_WEEKDAYS 9
+#define KEYWORD_WEEKENDS 10
+#define KEYWORD_RUN     11
+#define KEYWORD_MERGE   12
+#define KEYWORD_SKIP    13
+
+typedef struct _USER_DATA
+{
+    char buffer[MAX_CHARS+1];
+    uint8_t charCount;
+    uint8_t fieldCount;
+    uint8_t fieldPosition[MAX_FIELDS];
+    char fieldType[MAX_FIELDS];
+    uint32_t fieldValue[MAX_FIELDS];
+} USER_DATA;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+bool getsUart0NonBlocking(USER_DATA *data);
+void getsUart0(USER_DATA *data);
+void parseFields(USER_DATA *data);
+char* getFieldString(USER_DATA* data, uint8_t fieldNumber);
+uint32_t getFieldInteger(USER_DATA* data, uint8_t fieldNumber);
+uint32_t getFieldTime(USER_DATA* data, uint8_t fieldNumber);
+uint32_t getFieldDate(USER_DATA* data, uint8_t fieldNumber);
+uint8_t getFieldKeyword(USER_DATA* data, uint8_t fieldNumber);
+
+#endif
@@ -0,0 +1,135 @@
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target uC:       host (POSIX)
+// System Clock:    -
+
+// Parser throughput on the host: ns per command for parseFields with the getField* lookups a
+//   handler makes, and for the whole path from received characters (getsUart0NonBlocking
+//   through uart0stub.c) to typed fields
+// usage: parserbench [rounds], the corpus is the shell commands of the README
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "parser.h"
+#include "uart0stub.h"
+
+#define DEFAULT_ROUNDS 200000
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+const char* corpus[] =
+{
+    "time 18:29",
+    "date 2026-10-17",
+    "time",
+    "feed 0 7 65 7:30",
+    "feed 12 5 80 12:00 weekdays",
+    "feed 200 63 100 18:30 67 2026-12-20 2027-01-03",
+    "feed 3 delete",
+    "water 350",
+    "water",
+    "fill auto",
+    "fill motion",
+    "alert on",
+    "logs 28",
+    "schedule 2",
+    "baud 921600",
+    "flow on",
+    "catchup merge",
+    "config dump",
+    "config load 24 4D4F434E0300000001000000000000000000000000000000",
+    "perf",
+};
+#define CORPUS_SIZE (sizeof(corpus)/sizeof(corpus[0]))
+
+volatile uint32_t sink;                 // keeps the lookups from being optimized away
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+uint64_t nowNs(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec * 1000000000 + t.tv_nsec;
+}
+
+// the lookups a command handler does once the line is parsed
+void useFields(USER_DATA* data)
+{
+    uint8_t i;
+    uint32_t sum = data->fieldCount;
+    for (i = 0; i < data->fieldCount; i++)
+    {
+        sum += getFieldInteger(data, i) + getFieldTime(data, i) + getFieldDate(data, i) + getFieldKeyword(data, i);
+        if (getFieldString(data, i))
+            sum++;
+    }
+    sink += sum;
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t rounds = argc > 1 ? strtoul(argv[1], 0, 10) : DEFAULT_ROUNDS;
+    uint32_t r, i, length = 0, lines = 0;
+    USER_DATA data;
+    char* stream;
+    uint64_t start, parseNs, lineNs;
+
+    start = nowNs();
+    for (r = 0; r < rounds; r++)
+    {
+        for (i = 0; i < CORPUS_SIZE; i++)
+        {
+            strcpy(data.buffer, corpus[i]);
+            parseFields(&data);
+            useFields(&data);
+        }
+    }
+    parseNs = nowNs() - start;
+
+    // the same commands as typed, each ended by ENTER
+    for (i = 0; i < CORPUS_SIZE; i++)
+        length += strlen(corpus[i]) + 1;
+    stream = malloc(length);
+    length = 0;
+    for (i = 0; i < CORPUS_SIZE; i++)
+    {
+        memcpy(&stream[length], corpus[i], strlen(corpus[i]));
+        length += strlen(corpus[i]);
+        stream[length++] = 13;
+    }
+    data.charCount = 0;
+    start = nowNs();
+    for (r = 0; r < rounds; r++)
+    {
+        setUart0StubInput(stream, length);
+        while (getsUart0NonBlocking(&data))
+        {
+            parseFields(&data);
+            useFields(&data);
+            lines++;
+        }
+    }
+    lineNs = nowNs() - start;
+    free(stream);
+
+    printf("parser: %u commands x %u rounds\n", (unsigned)CORPUS_SIZE, rounds);
+    printf("parseFields + lookups: %.1f ns/command\n", (double)parseNs / ((double)rounds * CORPUS_SIZE));
+    printf("line assembly + parseFields + lookups: %.1f ns/command (%u lines)\n",
+           (double)lineNs / ((double)rounds * CORPUS_SIZE), lines);
+    return lines == rounds * CORPUS_SIZE ? 0 : 1;
+}
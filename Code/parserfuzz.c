@@ -0,0 +1,204 @@
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target uC:       host (POSIX)
+// System Clock:    -
+
+// Fuzz harness for the command line parser
+//   LLVMFuzzerTestOneInput feeds one input through getsUart0NonBlocking (via uart0stub.c) and
+//   parseFields, then checks what the handlers rely on: fieldPosition inside the line and on the
+//   first character of its field, a known fieldType, number fields equal to their digits read
+//   without overflow (an overflowed number must come back as 'x'), times and dates in range
+// Build with clang -fsanitize=fuzzer -DLIBFUZZER for libFuzzer, otherwise main() below mutates
+//   the command corpus for a number of runs, with AddressSanitizer catching out of bounds access
+// usage: parserfuzz [runs [seed]]
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "calendar.h"
+#include "parser.h"
+#include "uart0stub.h"
+
+#define DEFAULT_RUNS 2000000
+#define MAX_INPUT 600                   // longer than a line so the MAX_CHARS cut is reached
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void fail(const char* what, const uint8_t* input, size_t size)
+{
+    size_t i;
+    fprintf(stderr, "parserfuzz: %s, input:", what);
+    for (i = 0; i < size; i++)
+        fprintf(stderr, " %02X", input[i]);
+    fprintf(stderr, "\n");
+    abort();
+}
+
+// checks the fields of one parsed line, line holds the characters before parseFields changed them
+void checkFields(USER_DATA* data, const char* line, uint16_t length, const uint8_t* input, size_t size)
+{
+    uint8_t i;
+    uint16_t j;
+    uint64_t value;
+    if (data->fieldCount > MAX_FIELDS)
+        fail("fieldCount past MAX_FIELDS", input, size);
+    for (i = 0; i < data->fieldCount; i++)
+    {
+        uint8_t position = data->fieldPosition[i];
+        char c = line[position];
+        if (position >= length)
+            fail("fieldPosition past the line", input, size);
+        if (i > 0 && position <= data->fieldPosition[i-1])
+            fail("fieldPosition out of order", input, size);
+        if (!((c >= '0' && c <= '9') || ((c | 0x20) >= 'a' && (c | 0x20) <= 'z')))
+            fail("field does not start on a letter or digit", input, size);
+        if (data->buffer[position] != c)
+            fail("field start overwritten", input, size);
+        switch (data->fieldType[i])
+        {
+        case 'n':
+            value = 0;
+            for (j = position; data->buffer[j] != 0; j++)
+            {
+                if (data->buffer[j] < '0' || data->buffer[j] > '9')
+                    fail("number field with a non digit", input, size);
+                value = value * 10 + (data->buffer[j] - '0');
+                if (value > 0xFFFFFFFF)
+                    fail("overflowed number returned as 'n'", input, size);
+            }
+            if (getFieldInteger(data, i) != value)
+                fail("getFieldInteger differs from the digits", input, size);
+            break;
+        case 't':
+            if (getFieldTime(data, i) >= 86400 || getFieldTime(data, i) % 60 != 0)
+                fail("time of day out of range", input, size);
+            break;
+        case 'y':
+            if (getFieldDate(data, i) > LAST_DAY)
+                fail("date out of range", input, size);
+            break;
+        case 'a':
+            if (getFieldKeyword(data, i) > KEYWORD_SKIP || getFieldString(data, i) != &data->buffer[position])
+                fail("bad word field", input, size);
+            break;
+        case 'x':
+            break;
+        default:
+            fail("unknown fieldType", input, size);
+        }
+    }
+    // out of range field numbers read nothing
+    if (getFieldInteger(data, data->fieldCount) != 0 || getFieldString(data, MAX_FIELDS) != 0
+            || getFieldTime(data, 255) != 0 || getFieldDate(data, 255) != 0 || getFieldKeyword(data, 255) != 0)
+        fail("field past fieldCount read", input, size);
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t* input, size_t size)
+{
+    USER_DATA data;
+    char line[MAX_CHARS+1];
+    uint16_t length;
+    if (size > MAX_INPUT)
+        size = MAX_INPUT;
+    memset(&data, 0x5A, sizeof(data));
+    data.charCount = 0;
+    setUart0StubInput((const char*)input, size);
+    while (getsUart0NonBlocking(&data))
+    {
+        length = strlen(data.buffer);
+        if (length > MAX_CHARS)
+            fail("line longer than MAX_CHARS", input, size);
+        memcpy(line, data.buffer, length + 1);
+        parseFields(&data);
+        checkFields(&data, line, length, input, size);
+    }
+    if (data.charCount >= MAX_CHARS)
+        fail("charCount reached MAX_CHARS", input, size);
+    return 0;
+}
+
+#ifndef LIBFUZZER
+
+const char* seeds[] =
+{
+    "feed 200 63 100 18:30 67 2026-12-20 2027-01-03\r",
+    "time 23:59\rdate 2105-12-31\r",
+    "config load 24 4D4F434E03000000\r",
+    "water 4294967295\rwater 4294967296\r",
+    "logs 28; schedule 2; catchup skip\r",
+};
+#define SEED_COUNT (sizeof(seeds)/sizeof(seeds[0]))
+
+// characters the mutations insert, weighted towards the ones the parser branches on
+const char interesting[] = "0123456789:-; aZz\r\b\x7f\x01\xff";
+
+int main(int argc, char** argv)
+{
+    uint32_t runs = argc > 1 ? strtoul(argv[1], 0, 10) : DEFAULT_RUNS;
+    uint8_t input[MAX_INPUT];
+    uint32_t run, size, edits, i, at;
+    srand(argc > 2 ? strtoul(argv[2], 0, 10) : 1);
+    for (run = 0; run < runs; run++)
+    {
+        const char* seed = seeds[rand() % SEED_COUNT];
+        size = strlen(seed);
+        memcpy(input, seed, size);
+        edits = 1 + rand() % 8;
+        for (i = 0; i < edits; i++)
+        {
+            at = size ? rand() % size : 0;
+            switch (rand() % 5)
+            {
+            case 0:                     // replace a character
+                if (size)
+                    input[at] = interesting[rand() % (sizeof(interesting) - 1)];
+                break;
+            case 1:                     // insert a character
+                if (size < MAX_INPUT)
+                {
+                    memmove(&input[at+1], &input[at], size - at);
+                    input[at] = interesting[rand() % (sizeof(interesting) - 1)];
+                    size++;
+                }
+                break;
+            case 2:                     // insert a run of digits, for overflow
+                while (size < MAX_INPUT && rand() % 16)
+                {
+                    memmove(&input[at+1], &input[at], size - at);
+                    input[at] = '0' + rand() % 10;
+                    size++;
+                }
+                break;
+            case 3:                     // random byte
+                if (size)
+                    input[at] = rand();
+                break;
+            default:                    // drop a character
+                if (size)
+                {
+                    memmove(&input[at], &input[at+1], size - at - 1);
+                    size--;
+                }
+            }
+        }
+        if (rand() % 64 == 0)           // a line over MAX_CHARS
+            while (size < MAX_INPUT)
+                input[size++] = interesting[rand() % 12];
+        LLVMFuzzerTestOneInput(input, size);
+    }
+    printf("parserfuzz: %u runs ok\n", runs);
+    return 0;
+}
+
+#endif
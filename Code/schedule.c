@@ -0,0 +1,453 @@
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target uC:       TM4C123GH6PM
+// System Clock:    -
+
+// RAM copy of the feeding schedule, loaded once at boot and written through to EEPROM
+//   slot i is one packed word at EE_SCHEDULE+i:
+//     bits 10-0  minute of the day (0-1439), anything above means the slot is free
+//     bits 17-11 pwm (0-100)
+//     bits 23-18 duration in seconds (0-63)
+//     bits 30-24 weekdays, bit 24 Sunday, words written before weekdays existed read as every day
+//     bit 31     reserved, written as 1 like erased EEPROM
+//   the date ranges are a table of MAX_RANGES entries at EE_RANGES, two words each:
+//     the slot number (RANGE_FREE when unused), then the first day in bits 15-0 and the last in 31-16
+//   only the packed words are kept in RAM, a slot is unpacked when it is asked for
+//
+// The next feeding is found from RTC seconds (seconds since 1970-01-01) without stepping through days:
+//   the feedings without a date range are also sorted into one list per weekday, the first later one
+//   in today's list or the first one of the next weekday whose list is not empty is the candidate,
+//   and each of the few ranged feedings is checked on its own from its mask and dates
+// Feedings at the same time are ordered by slot, so (RTC seconds, slot) is a cursor that steps through
+//   every feeding once, equal times included
+// findNextFeed runs in the hibernate and timer isrs, so the main loop changes the RAM copy and the lists
+//   with interrupts disabled and programs the EEPROM afterwards
+// Between deferFeedWrites and commitFeedWrites (a command batch) only the RAM copy changes and the
+//   changed words are marked, the batch then programs them and seals each region once
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "eeprom.h"
+#include "calendar.h"
+#include "layout.h"
+#include "schedule.h"
+
+#define SLOT_MINUTE_M       0x000007FF
+#define SLOT_PWM_S          11
+#define SLOT_PWM_M          0x0003F800
+#define SLOT_DURATION_S     18
+#define SLOT_DURATION_M     0x00FC0000
+#define SLOT_DAYS_S         24
+#define SLOT_DAYS_M         0x7F000000
+#define MINUTES_PER_DAY     1440
+#define RANGE_LAST_S        16
+#define RANGE_DAY_M         0xFFFF
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+uint32_t slotWords[MAX_SLOTS];      // packed words as stored, also the contents of the region crc
+uint32_t rangeWords[2*MAX_RANGES];  // date range table as stored
+uint8_t order[MAX_SLOTS];           // used slots sorted by time of day, equal times by slot
+uint16_t orderCount = 0;
+uint8_t dayOrder[7][MAX_SLOTS];     // used slots without a date range that feed on each weekday, by time
+uint16_t dayCount[7];
+bool deferWrites = false;
+uint32_t slotDirty[MAX_SLOTS/32];   // bit per slot word changed and not yet programmed
+uint16_t rangeDirty = 0;            // bit per date range table word
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+// Packs a feeding into its EEPROM word, unused slots, invalid times and empty weekday masks pack to
+//  SLOT_EMPTY
+uint32_t packFeedSlot(const FEED_SLOT* feed)
+{
+    uint32_t duration = feed->duration > MAX_DURATION ? MAX_DURATION : feed->duration;
+    uint32_t pwm = feed->pwm > MAX_PWM ? MAX_PWM : feed->pwm;
+    uint32_t days = feed->days & ALL_DAYS;
+    if (feed->flag >= MAX_SLOTS || feed->hour > 23 || feed->minute > 59 || days == 0)
+        return SLOT_EMPTY;
+    return SLOT_RESERVED_M | (days << SLOT_DAYS_S) | (duration << SLOT_DURATION_S) | (pwm << SLOT_PWM_S)
+            | (feed->hour*60 + feed->minute);
+}
+
+// Packs the date range of a feeding into its table word, RANGE_NONE when it has neither date
+uint32_t packFeedRange(const FEED_SLOT* feed)
+{
+    uint32_t last = feed->lastDay > NO_LAST_DAY ? NO_LAST_DAY : feed->lastDay;
+    if (feed->firstDay == 0 && last == NO_LAST_DAY)
+        return RANGE_NONE;
+    return feed->firstDay | (last << RANGE_LAST_S);
+}
+
+// Unpacks a slot word, the feeding gets no date range
+void unpackFeedSlot(uint32_t word, uint16_t slot, FEED_SLOT* feed)
+{
+    uint32_t minute = word & SLOT_MINUTE_M;
+    feed->firstDay = 0;
+    feed->lastDay = NO_LAST_DAY;
+    if (minute >= MINUTES_PER_DAY)
+    {
+        feed->flag = SLOT_FREE;
+        feed->duration = feed->pwm = feed->hour = feed->minute = feed->days = 0;
+        return;
+    }
+    feed->flag = slot;
+    feed->duration = (word & SLOT_DURATION_M) >> SLOT_DURATION_S;
+    feed->pwm = (word & SLOT_PWM_M) >> SLOT_PWM_S;
+    feed->days = (word & SLOT_DAYS_M) >> SLOT_DAYS_S;
+    feed->hour = minute / 60;
+    feed->minute = minute % 60;
+}
+
+// Entry of the date range table whose slot word is key, -1 if none
+int8_t findRange(uint32_t key)
+{
+    int8_t i;
+    for (i = 0; i < MAX_RANGES; i++)
+        if (rangeWords[2*i] == key)
+            return i;
+    return -1;
+}
+
+void getFeedSlot(uint16_t slot, FEED_SLOT* feed)
+{
+    int8_t entry = findRange(slot);
+    unpackFeedSlot(slotWords[slot], slot, feed);
+    if (entry >= 0 && feed->flag != SLOT_FREE)
+    {
+        feed->firstDay = rangeWords[2*entry + 1] & RANGE_DAY_M;
+        feed->lastDay = rangeWords[2*entry + 1] >> RANGE_LAST_S;
+    }
+}
+
+uint32_t getFeedWord(uint16_t slot)
+{
+    return slotWords[slot];
+}
+
+// A slot is in use when its word holds a minute of the day
+bool isFeedSlotUsed(uint16_t slot)
+{
+    return (slotWords[slot] & SLOT_MINUTE_M) < MINUTES_PER_DAY;
+}
+
+uint32_t getFeedSeconds(uint16_t slot)
+{
+    return (slotWords[slot] & SLOT_MINUTE_M) * 60;
+}
+
+uint8_t getFeedDays(uint16_t slot)
+{
+    return (slotWords[slot] & SLOT_DAYS_M) >> SLOT_DAYS_S;
+}
+
+// Position of a feeding in the time of day order, its seconds with the slot below them
+uint32_t getFeedKey(uint32_t seconds, uint16_t slot)
+{
+    return seconds * MAX_SLOTS + slot;
+}
+
+// Binary search for the position in list of the first feeding after the one at seconds in slot after
+//  (FEED_CURSOR_START for before every feeding at seconds), count if none
+uint16_t findListPosition(const uint8_t* list, uint16_t count, uint32_t seconds, int16_t after)
+{
+    uint32_t key = getFeedKey(seconds, after + 1);
+    uint16_t low = 0, high = count, middle;
+    while (low < high)
+    {
+        middle = (low + high) / 2;
+        if (getFeedKey(getFeedSeconds(list[middle]), list[middle]) < key)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return low;
+}
+
+void insertIntoList(uint8_t* list, uint16_t* count, uint16_t slot)
+{
+    uint16_t position = findListPosition(list, *count, getFeedSeconds(slot), slot);
+    uint16_t i;
+    for (i = *count; i > position; i--)
+        list[i] = list[i - 1];
+    list[position] = slot;
+    (*count)++;
+}
+
+// The slot still holds its old time, so it is found where it was inserted
+void removeFromList(uint8_t* list, uint16_t* count, uint16_t slot)
+{
+    uint16_t i = findListPosition(list, *count, getFeedSeconds(slot), slot - 1);
+    if (i == *count || list[i] != slot)
+        return;
+    (*count)--;
+    for (; i < *count; i++)
+        list[i] = list[i + 1];
+}
+
+// Adds a used slot to the time order and, without a date range, to the lists of its weekdays
+void insertIntoOrder(uint16_t slot)
+{
+    uint8_t days = getFeedDays(slot);
+    uint8_t i;
+    insertIntoList(order, &orderCount, slot);
+    if (findRange(slot) >= 0)
+        return;
+    for (i = 0; i < 7; i++)
+        if (days & (1 << i))
+            insertIntoList(dayOrder[i], &dayCount[i], slot);
+}
+
+// Call with the slot word and date range still as they were inserted
+void removeFromOrder(uint16_t slot)
+{
+    uint8_t days = getFeedDays(slot);
+    uint8_t i;
+    removeFromList(order, &orderCount, slot);
+    if (findRange(slot) >= 0)
+        return;
+    for (i = 0; i < 7; i++)
+        if (days & (1 << i))
+            removeFromList(dayOrder[i], &dayCount[i], slot);
+}
+
+// Steps through the feedings due after from and up to until in time order, in a single pass of
+//  findNextFeed() calls, returns how many there are (feedings at the same time each count), -1 in
+//  *latest if none
+//  *latest and *latestTime get the last of them, *duration their auger times added up
+uint16_t findMissedFeeds(uint32_t from, uint32_t until, int16_t* latest, uint32_t* latestTime, uint32_t* duration)
+{
+    uint32_t when;
+    uint16_t count = 0;
+    int16_t slot;
+    *latest = -1;
+    *duration = 0;
+    for (slot = findNextFeed(from, FEED_CURSOR_END, &when); slot >= 0 && when <= until;
+            slot = findNextFeed(when, slot, &when))
+    {
+        *latest = slot;
+        *latestTime = when;
+        *duration += (slotWords[slot] & SLOT_DURATION_M) >> SLOT_DURATION_S;
+        count++;
+    }
+    return count;
+}
+
+// Writes one word of the date range table, ranges is the table as stored and takes the new value
+void writeRangeWord(uint32_t* ranges, uint16_t index, uint32_t value)
+{
+    ranges[index] = value;
+    writeRegionWord(REGION_RANGES, ranges, EE_RANGES + index);
+}
+
+// Reads every slot and date range from EEPROM, call once after validateLayout() and again after the
+//  slots are replaced
+//  a range entry left behind by a reset while its slot was cleared is freed here
+//  the queue is drained first so the reads with interrupts disabled do not wait on the EEPROM
+void loadSchedule(void)
+{
+    uint32_t ranges[2*MAX_RANGES];      // as stored
+    uint32_t state;
+    uint16_t i;
+    drainEepromQueue();
+    state = _disable_interrupts();
+    readEepromBlock(EE_SCHEDULE, slotWords, MAX_SLOTS);
+    readEepromBlock(EE_RANGES, rangeWords, 2*MAX_RANGES);
+    for (i = 0; i < 2*MAX_RANGES; i++)
+        ranges[i] = rangeWords[i];
+    for (i = 0; i < MAX_RANGES; i++)
+        if (rangeWords[2*i] != RANGE_FREE && (rangeWords[2*i] >= MAX_SLOTS || !isFeedSlotUsed(rangeWords[2*i])))
+            rangeWords[2*i] = RANGE_FREE;
+    orderCount = 0;
+    for (i = 0; i < 7; i++)
+        dayCount[i] = 0;
+    for (i = 0; i < MAX_SLOTS/32; i++)  // a deferred change is replaced by what was loaded
+        slotDirty[i] = 0;
+    rangeDirty = 0;
+    for (i = 0; i < MAX_SLOTS; i++)
+        if (isFeedSlotUsed(i))
+            insertIntoOrder(i);
+    _restore_interrupts(state);
+    for (i = 0; i < MAX_RANGES; i++)
+        if (ranges[2*i] != rangeWords[2*i])
+            writeRangeWord(ranges, 2*i, RANGE_FREE);
+}
+
+uint16_t getFeedCount(void)
+{
+    return orderCount;
+}
+
+// Slot of the feeding at position (0 earliest) in time of day order
+uint16_t getFeedByTime(uint16_t position)
+{
+    return order[position];
+}
+
+// Finds the first feeding after the one at now (RTC seconds) in slot after, in (time, slot) order,
+//  stores its RTC seconds in when and returns its slot, -1 when nothing is left to feed
+//  after is FEED_CURSOR_START to include every feeding at now, FEED_CURSOR_END to skip them all,
+//  passing back the slot and time returned steps through feedings at the same time one by one
+//  costs one binary search in today's list and a few steps per date range entry, however many days
+//  away the feeding is
+int16_t findNextFeed(uint32_t now, int16_t after, uint32_t* when)
+{
+    uint32_t day = now / SECONDS_PER_DAY;
+    uint32_t seconds = now % SECONDS_PER_DAY;
+    uint32_t first, last, start, time;
+    uint8_t weekday = getWeekday(day);
+    uint8_t active = 0;
+    uint8_t i, ahead;
+    uint16_t position, slot;
+    int16_t next = -1;
+
+    position = findListPosition(dayOrder[weekday], dayCount[weekday], seconds, after);
+    for (i = 0; i < 7; i++)
+        if (dayCount[i] != 0)
+            active |= 1 << i;
+    if (position < dayCount[weekday])
+    {
+        next = dayOrder[weekday][position];
+        *when = day * SECONDS_PER_DAY + getFeedSeconds(next);
+    }
+    else if (active != 0)
+    {
+        ahead = 1 + getDaysUntil(active, (weekday + 1) % 7);
+        next = dayOrder[(weekday + ahead) % 7][0];
+        *when = (day + ahead) * SECONDS_PER_DAY + getFeedSeconds(next);
+    }
+
+    for (i = 0; i < MAX_RANGES; i++)
+    {
+        slot = rangeWords[2*i];
+        if (slot >= MAX_SLOTS)
+            continue;
+        first = rangeWords[2*i + 1] & RANGE_DAY_M;
+        last = rangeWords[2*i + 1] >> RANGE_LAST_S;
+        start = getFeedKey(getFeedSeconds(slot), slot) >= getFeedKey(seconds, after + 1) ? day : day + 1;
+        if (start < first)
+            start = first;
+        start += getDaysUntil(getFeedDays(slot), getWeekday(start));
+        if (start > last)
+            continue;
+        time = start * SECONDS_PER_DAY + getFeedSeconds(slot);
+        if (next < 0 || time < *when || (time == *when && slot < next))
+        {
+            next = slot;
+            *when = time;
+        }
+    }
+    return next;
+}
+
+// Updates the RAM copy, the time order and EEPROM, returns false and changes nothing when the feeding
+//  needs a date range entry and the table is full, or its range ends before it starts
+//  a new date range is stored before the slot word and an old one freed after it, so a reset in
+//  between leaves a dated feeding at worst unlimited for a moment, never an undated one limited
+bool writeFeedSlot(uint16_t slot, const FEED_SLOT* feed)
+{
+    uint32_t word = packFeedSlot(feed);
+    uint32_t range = word == SLOT_EMPTY ? RANGE_NONE : packFeedRange(feed);
+    uint32_t ranges[2*MAX_RANGES];      // as stored, one step at a time
+    uint32_t previous = slotWords[slot];
+    uint32_t state;
+    uint16_t i;
+    int8_t entry = findRange(slot);
+    if (range != RANGE_NONE)
+    {
+        if (feed->firstDay > feed->lastDay || feed->firstDay > LAST_DAY)
+            return false;
+        if (entry < 0)
+            entry = findRange(RANGE_FREE);
+        if (entry < 0)
+            return false;
+    }
+
+    for (i = 0; i < 2*MAX_RANGES; i++)
+        ranges[i] = rangeWords[i];
+    state = _disable_interrupts();
+    if (isFeedSlotUsed(slot))
+        removeFromOrder(slot);
+    if (range != RANGE_NONE)
+    {
+        rangeWords[2*entry + 1] = range;
+        rangeWords[2*entry] = slot;
+    }
+    else if (entry >= 0)
+        rangeWords[2*entry] = RANGE_FREE;
+    slotWords[slot] = word;
+    if (isFeedSlotUsed(slot))
+        insertIntoOrder(slot);
+    _restore_interrupts(state);
+
+    if (deferWrites)
+    {
+        if (previous != word)
+            slotDirty[slot >> 5] |= (uint32_t)1 << (slot & 31);
+        for (i = 0; i < 2*MAX_RANGES; i++)
+            if (ranges[i] != rangeWords[i])
+                rangeDirty |= 1 << i;
+        return true;
+    }
+    if (range != RANGE_NONE)
+    {
+        writeRangeWord(ranges, 2*entry + 1, range);
+        writeRangeWord(ranges, 2*entry, slot);
+    }
+    writeRegionWord(REGION_SCHEDULE, slotWords, EE_SCHEDULE + slot);
+    if (range == RANGE_NONE && entry >= 0)
+        writeRangeWord(ranges, 2*entry, RANGE_FREE);
+    return true;
+}
+
+// Marks the slot unused
+void clearFeedSlot(uint16_t slot)
+{
+    FEED_SLOT feed = {SLOT_FREE, 0, 0, 0, 0, 0, 0, NO_LAST_DAY};
+    writeFeedSlot(slot, &feed);
+}
+
+// Holds the EEPROM writes of writeFeedSlot and clearFeedSlot back until commitFeedWrites
+void deferFeedWrites(void)
+{
+    deferWrites = true;
+}
+
+// Programs the slot and date range words changed since deferFeedWrites, a single word through
+//  writeRegionWord, more through commitSchedule so a reset leaves all of them or none
+void commitFeedWrites(void)
+{
+    uint16_t i, count = 0, add = 0;
+    uint8_t region = REGION_SCHEDULE;
+    deferWrites = false;
+    for (i = 0; i < MAX_SLOTS; i++)
+        if (slotDirty[i >> 5] & ((uint32_t)1 << (i & 31)))
+        {
+            count++;
+            add = EE_SCHEDULE + i;
+        }
+    for (i = 0; i < 2*MAX_RANGES; i++)
+        if (rangeDirty & (1 << i))
+        {
+            count++;
+            add = EE_RANGES + i;
+            region = REGION_RANGES;
+        }
+    if (count == 1)
+        writeRegionWord(region, region == REGION_RANGES ? rangeWords : slotWords, add);
+    else if (count > 1)
+        commitSchedule(slotWords, rangeWords);
+    for (i = 0; i < MAX_SLOTS/32; i++)
+        slotDirty[i] = 0;
+    rangeDirty = 0;
+}
@@ -0,0 +1,62 @@
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target uC:       TM4C123GH6PM
+// System Clock:    -
+
+#ifndef SCHEDULE_H_
+#define SCHEDULE_H_
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#define MAX_SLOTS 256               // slot numbers must fit in a byte (time order, snapshot entries)
+#define MAX_RANGES 8                // feedings that can carry a date range at the same time
+#define SLOT_FREE 0xFFFF            // flag value of an unused slot
+#define SLOT_EMPTY 0xFFFFFFFF       // EEPROM word of an unused slot
+#define SLOT_RESERVED_M 0x80000000  // always 1 in EEPROM
+#define RANGE_FREE 0xFFFFFFFF       // slot word of an unused date range entry
+#define RANGE_NONE 0xFFFFFFFF       // packed date range of a feeding without one
+#define NO_LAST_DAY 0xFFFF          // lastDay of a feeding without an end date
+#define MAX_DURATION 63             // auger on time limit in seconds (6 bit field)
+#define MAX_PWM 100
+#define FEED_CURSOR_START -1        // findNextFeed after: the feedings at now are still to come
+#define FEED_CURSOR_END 255         // findNextFeed after: the feedings at now are done (last slot)
+
+// One feeding unpacked from its EEPROM words (see packFeedSlot and packFeedRange)
+typedef struct _FEED_SLOT
+{
+    uint32_t flag;                  // slot index when in use, SLOT_FREE otherwise
+    uint32_t duration;              // auger on time in seconds
+    uint32_t pwm;                   // auger duty cycle in percent
+    uint32_t hour;
+    uint32_t minute;
+    uint32_t days;                  // weekdays it feeds on, bit 0 Sunday (see calendar.h)
+    uint32_t firstDay;              // first date it feeds on as a day number, 0 for no start date
+    uint32_t lastDay;               // last date it feeds on as a day number, NO_LAST_DAY for no end date
+} FEED_SLOT;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+uint32_t packFeedSlot(const FEED_SLOT* feed);
+uint32_t packFeedRange(const FEED_SLOT* feed);
+void unpackFeedSlot(uint32_t word, uint16_t slot, FEED_SLOT* feed);
+void loadSchedule(void);
+void getFeedSlot(uint16_t slot, FEED_SLOT* feed);
+uint32_t getFeedWord(uint16_t slot);
+bool isFeedSlotUsed(uint16_t slot);
+uint32_t getFeedSeconds(uint16_t slot);
+uint16_t getFeedCount(void);
+uint16_t getFeedByTime(uint16_t position);
+bool writeFeedSlot(uint16_t slot, const FEED_SLOT* feed);
+void clearFeedSlot(uint16_t slot);
+void deferFeedWrites(void);
+void commitFeedWrites(void);
+int16_t findNextFeed(uint32_t now, int16_t after, uint32_t* when);
+uint16_t findMissedFeeds(uint32_t from, uint32_t until, int16_t* latest, uint32_t* latestTime, uint32_t* duration);
+
+#endif
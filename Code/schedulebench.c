@@ -0,0 +1,150 @@
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target uC:       host (POSIX)
+// System Clock:    -
+
+// Next feeding lookup of schedule.c against the linear scan it replaced, on the EEPROM model
+//   the scan looks at every slot and takes the earliest next occurrence, as setNextEvent did before
+//   the sorted lists (with the weekday masks added so both answer the same question)
+//   findNextFeed does one binary search in the day's list; both must agree on every lookup, on the
+//   slot too: feedings at the same time go in slot order, and the scan keeps the lowest slot
+//   sizes 10, 100 and 256 feedings at random times and weekdays, 256 is MAX_SLOTS: slot numbers
+//   are stored in bytes (time order, snapshot entries), so 1000 feedings do not fit this schedule
+//   also times loadSchedule, which rebuilds the lists from the slot words
+// usage: schedulebench [lookups], EEPROM_IMAGE names the image (erased first)
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "calendar.h"
+#include "eeprom.h"
+#include "eepromhost.h"
+#include "layout.h"
+#include "schedule.h"
+
+#define DEFAULT_LOOKUPS     200000
+#define START_TIME          1792281600  // 2026-10-18 00:00
+#define LOAD_ROUNDS         200
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+const uint16_t sizes[] = {10, 100, MAX_SLOTS};
+#define SIZE_COUNT (sizeof(sizes)/sizeof(sizes[0]))
+
+uint32_t* times;                        // RTC seconds looked up
+volatile uint32_t sink;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+uint64_t nowNs(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec * 1000000000 + t.tv_nsec;
+}
+
+// the scan: every used slot, its next occurrence after now from its time and weekdays
+int16_t scanNextFeed(uint32_t now, uint32_t* when)
+{
+    uint32_t day = now / SECONDS_PER_DAY;
+    uint32_t seconds = now % SECONDS_PER_DAY;
+    uint8_t weekday = getWeekday(day);
+    uint32_t start, time;
+    FEED_SLOT feed;
+    int16_t next = -1;
+    uint16_t slot;
+    for (slot = 0; slot < MAX_SLOTS; slot++)
+    {
+        if (!isFeedSlotUsed(slot))
+            continue;
+        unpackFeedSlot(getFeedWord(slot), slot, &feed);
+        start = getFeedSeconds(slot) > seconds ? day : day + 1;
+        start += getDaysUntil(feed.days, (weekday + start - day) % 7);
+        time = start * SECONDS_PER_DAY + getFeedSeconds(slot);
+        if (next < 0 || time < *when)
+        {
+            next = slot;
+            *when = time;
+        }
+    }
+    return next;
+}
+
+// replaces the schedule with count feedings at random minutes and weekdays
+void makeSchedule(uint16_t count)
+{
+    FEED_SLOT feed;
+    uint16_t slot;
+    for (slot = 0; slot < MAX_SLOTS; slot++)
+    {
+        feed.flag = slot < count ? slot : SLOT_FREE;
+        feed.duration = 1 + rand() % MAX_DURATION;
+        feed.pwm = 50 + rand() % 51;
+        feed.hour = rand() % 24;
+        feed.minute = rand() % 60;
+        feed.days = rand() % 2 ? ALL_DAYS : 1 + rand() % ALL_DAYS;
+        feed.firstDay = 0;
+        feed.lastDay = NO_LAST_DAY;
+        writeFeedSlot(slot, &feed);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t lookups = argc > 1 ? strtoul(argv[1], 0, 10) : DEFAULT_LOOKUPS;
+    uint32_t i, when, scanWhen, mismatches = 0;
+    uint64_t start, sortedNs, scanNs, loadNs;
+    int16_t slot;
+    uint8_t s;
+
+    initEeprom();
+    eraseEepromImage();
+    initLayout();
+    validateLayout();
+    loadSchedule();
+    times = malloc(lookups * sizeof(uint32_t));
+    srand(1);
+    for (i = 0; i < lookups; i++)
+        times[i] = START_TIME + rand() % (14 * SECONDS_PER_DAY);
+
+    printf("schedulebench: %u lookups per size\n", lookups);
+    for (s = 0; s < SIZE_COUNT; s++)
+    {
+        makeSchedule(sizes[s]);
+        for (i = 0; i < lookups; i++)
+        {
+            slot = findNextFeed(times[i], FEED_CURSOR_END, &when);
+            mismatches += scanNextFeed(times[i], &scanWhen) != slot || when != scanWhen;
+        }
+        start = nowNs();
+        for (i = 0; i < lookups; i++)
+            sink += findNextFeed(times[i], FEED_CURSOR_END, &when) + when;
+        sortedNs = nowNs() - start;
+        start = nowNs();
+        for (i = 0; i < lookups; i++)
+            sink += scanNextFeed(times[i], &when) + when;
+        scanNs = nowNs() - start;
+        start = nowNs();
+        for (i = 0; i < LOAD_ROUNDS; i++)
+            loadSchedule();
+        loadNs = nowNs() - start;
+        printf("%3u feedings: findNextFeed %6.1f ns, linear scan %7.1f ns, loadSchedule %.1f us\n",
+               sizes[s], (double)sortedNs / lookups, (double)scanNs / lookups, loadNs / 1e3 / LOAD_ROUNDS);
+    }
+    free(times);
+    if (mismatches)
+        printf("schedulebench: FAILED findNextFeed and the scan disagree on %u lookups\n", mismatches);
+    return mismatches ? 1 : 0;
+}
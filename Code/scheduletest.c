@@ -0,0 +1,149 @@
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target uC:       host (POSIX)
+// System Clock:    -
+
+// The (time, slot) cursor of findNextFeed and findMissedFeeds on the EEPROM model
+//   random schedules with feedings crowded onto a few times of day, with weekdays and date ranges,
+//   are walked for two weeks by passing back each time and slot returned; the walk must give every
+//   feeding on every day it is due exactly once, in (time, slot) order, as counted from each slot on
+//   its own, and findMissedFeeds must count the same feedings for random windows
+// usage: scheduletest [schedules], EEPROM_IMAGE names the image (erased first)
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "calendar.h"
+#include "eeprom.h"
+#include "eepromhost.h"
+#include "layout.h"
+#include "schedule.h"
+
+#define DEFAULT_SCHEDULES   200
+#define START_DAY           20743       // 2026-10-17
+#define WALK_DAYS           14
+#define WINDOWS             50
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+FEED_SLOT feeds[MAX_SLOTS];
+bool failed = false;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void check(bool ok, const char* what, uint32_t schedule)
+{
+    if (!ok && !failed)
+        printf("scheduletest: FAILED %s, schedule %u\n", what, schedule);
+    failed |= !ok;
+}
+
+// feedings due after from and up to until, counted slot by slot and day by day
+uint16_t countFeeds(uint32_t from, uint32_t until)
+{
+    uint32_t day, time;
+    uint16_t slot, count = 0;
+    for (slot = 0; slot < MAX_SLOTS; slot++)
+    {
+        if (feeds[slot].flag == SLOT_FREE)
+            continue;
+        for (day = from / SECONDS_PER_DAY; day <= until / SECONDS_PER_DAY; day++)
+        {
+            time = day * SECONDS_PER_DAY + feeds[slot].hour * 3600 + feeds[slot].minute * 60;
+            if (time > from && time <= until && (feeds[slot].days & (1 << getWeekday(day)))
+                    && day >= feeds[slot].firstDay && day <= feeds[slot].lastDay)
+                count++;
+        }
+    }
+    return count;
+}
+
+// count feedings on a few times of day, some slots free, a few with date ranges
+void makeSchedule(uint16_t count)
+{
+    uint16_t slot, ranges = 0;
+    for (slot = 0; slot < MAX_SLOTS; slot++)       // frees the date ranges before they are handed out again
+        if (feeds[slot].firstDay != 0 || feeds[slot].lastDay != NO_LAST_DAY)
+            clearFeedSlot(slot);
+    for (slot = 0; slot < MAX_SLOTS; slot++)
+    {
+        FEED_SLOT* feed = &feeds[slot];
+        feed->flag = slot < count && rand() % 8 ? slot : SLOT_FREE;
+        feed->duration = 1 + rand() % MAX_DURATION;
+        feed->pwm = 50 + rand() % 51;
+        feed->hour = 6 * (rand() % 4);
+        feed->minute = rand() % 2 ? 0 : 30;
+        feed->days = rand() % 2 ? ALL_DAYS : 1 + rand() % ALL_DAYS;
+        feed->firstDay = 0;
+        feed->lastDay = NO_LAST_DAY;
+        if (feed->flag != SLOT_FREE && ranges < MAX_RANGES && rand() % 16 == 0)
+        {
+            feed->firstDay = START_DAY + rand() % WALK_DAYS;
+            feed->lastDay = feed->firstDay + rand() % WALK_DAYS;
+            ranges++;
+        }
+        check(writeFeedSlot(slot, feed), "writeFeedSlot refused a feeding", 0);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t schedules = argc > 1 ? strtoul(argv[1], 0, 10) : DEFAULT_SCHEDULES;
+    uint32_t n, w, when, lastWhen, from, until, latestTime, duration, steps = 0;
+    uint32_t start = START_DAY * SECONDS_PER_DAY, end = start + WALK_DAYS * SECONDS_PER_DAY;
+    int16_t slot, lastSlot, latest;
+    uint16_t count;
+
+    initEeprom();
+    eraseEepromImage();
+    initLayout();
+    validateLayout();
+    loadSchedule();
+    srand(1);
+    for (n = 0; n < schedules && !failed; n++)
+    {
+        makeSchedule(n % 3 == 0 ? 8 : n % 3 == 1 ? 64 : MAX_SLOTS);
+        if (n % 2)
+            loadSchedule();             // the lists rebuilt from EEPROM must walk the same
+
+        // the walk starts before every feeding at start, at 00:00 of the first day
+        count = 0;
+        lastWhen = start;
+        lastSlot = FEED_CURSOR_START;
+        for (slot = findNextFeed(start, FEED_CURSOR_START, &when); slot >= 0 && when < end;
+                slot = findNextFeed(when, slot, &when))
+        {
+            check(when > lastWhen || (when == lastWhen && slot > lastSlot), "walk out of (time, slot) order", n);
+            check(feeds[slot].flag == (uint32_t)slot, "walk gave a free slot", n);
+            lastWhen = when;
+            lastSlot = slot;
+            count++;
+        }
+        check(count == countFeeds(start - 1, end - 1), "walk count", n);
+        steps += count;
+
+        for (w = 0; w < WINDOWS; w++)
+        {
+            from = start + rand() % (WALK_DAYS * SECONDS_PER_DAY / 2);
+            from -= from % 60 * (rand() % 2);   // often on a feeding minute
+            until = from + rand() % (WALK_DAYS * SECONDS_PER_DAY / 2);
+            count = findMissedFeeds(from, until, &latest, &latestTime, &duration);
+            check(count == countFeeds(from, until), "findMissedFeeds count", n);
+            check((count == 0) == (latest < 0), "findMissedFeeds latest", n);
+        }
+    }
+    printf("scheduletest: %u schedules walked for %u days, %u feedings stepped through%s\n", n, WALK_DAYS,
+           steps, failed ? ", FAILED" : "");
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,283 @@
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target uC:       TM4C123GH6PM
+// System Clock:    40 MHz
+
+// Hardware configuration:
+// Timer 0 (32-bit, A+B) counts up freely at the system clock, its match interrupt runs the
+//   software timers
+//
+// Software timers on a hashed timing wheel of WHEEL_SIZE buckets, one per 100 ms tick
+//   a timer is linked into bucket (expiry tick % WHEEL_SIZE), so start and stop are O(1) and
+//   timers further than one turn away stay in their bucket until their tick comes round
+//   the match is set to the next bucket holding a timer, found in a bitmap of used buckets, so
+//   empty ticks cost no interrupt and timers due on the same tick share one
+// Higher priority isrs start and stop timers, so the service interrupt moves the wheel and unlinks
+//   or relinks a timer with interrupts disabled, they are only enabled while a callback runs
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "tm4c123gh6pm.h"
+#include "timers.h"
+
+#define TICK_CYCLES         (40000*TIMER_TICK_MS)   // 40 MHz
+#define WHEEL_SIZE          128         // 12.8 s per turn, must be a power of 2 and a multiple of 32
+#define WHEEL_MASK          (WHEEL_SIZE-1)
+#define WHEEL_WORDS         (WHEEL_SIZE/32)
+#define NO_TIMER            -1
+
+typedef struct _SOFT_TIMER
+{
+    uint32_t expires;                   // tick it runs on
+    uint32_t period;                    // ticks, 0 for a one-shot
+    TIMER_CALLBACK callback;
+    int8_t next;                        // bucket list, NO_TIMER ends it
+    int8_t prev;                        // NO_TIMER when first in its bucket
+    bool running;
+} SOFT_TIMER;
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+SOFT_TIMER timers[MAX_TIMERS];
+int8_t wheel[WHEEL_SIZE];               // first timer of each bucket
+uint32_t wheelMap[WHEEL_WORDS];         // bit set for each bucket holding a timer
+uint32_t wheelTick = 0;                 // last tick run by timerServiceIsr
+uint32_t wheelCycles = 0;               // timer 0 count at the start of wheelTick
+bool inService = false;                 // timerServiceIsr arms the match itself when it is done
+uint32_t timerWakeups = 0;
+uint32_t timerCallbacks = 0;
+
+// index of the lowest set bit of a 32-bit word, multiply by a de Bruijn sequence
+const uint8_t lowestBit[32] =
+{
+    0, 1, 28, 2, 29, 14, 24, 3, 30, 22, 20, 15, 25, 17, 4, 8,
+    31, 27, 13, 23, 21, 19, 16, 7, 26, 12, 18, 6, 11, 5, 10, 9
+};
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+// Starts timer 0 counting up through its full 32-bit range, the match interrupt is armed by armWheel
+void initTimers(void)
+{
+    uint16_t i;
+    for (i = 0; i < WHEEL_SIZE; i++)
+        wheel[i] = NO_TIMER;
+    for (i = 0; i < WHEEL_WORDS; i++)
+        wheelMap[i] = 0;
+    for (i = 0; i < MAX_TIMERS; i++)
+        timers[i].running = false;
+
+    SYSCTL_RCGCTIMER_R |= SYSCTL_RCGCTIMER_R0;
+    _delay_cycles(3);
+    TIMER0_CTL_R &= ~TIMER_CTL_TAEN;                        // turn-off timer before reconfiguring
+    TIMER0_CFG_R = TIMER_CFG_32_BIT_TIMER;                  // configure as 32-bit timer (A+B)
+    TIMER0_TAMR_R = TIMER_TAMR_TAMR_PERIOD | TIMER_TAMR_TACDIR | TIMER_TAMR_TAMIE;
+                                                            // periodic count up, interrupt on match
+    TIMER0_TAILR_R = 0xFFFFFFFF;                            // wrap every 107 s
+    TIMER0_TAMATCHR_R = TICK_CYCLES*WHEEL_SIZE;
+    TIMER0_IMR_R = TIMER_IMR_TAMIM;                         // turn-on match interrupt in timer module
+    TIMER0_TAV_R = 0;
+    wheelTick = 0;
+    wheelCycles = 0;
+    TIMER0_CTL_R |= TIMER_CTL_TAEN;                         // turn-on timer
+    NVIC_EN0_R = 1 << (INT_TIMER0A-16);                     // turn-on interrupt 35 (TIMER0A) in NVIC
+}
+
+// Number of ticks from bucket to the next bucket holding a timer (1 to WHEEL_SIZE, bucket itself
+//  counts as a full turn), 0 if every bucket is empty
+uint32_t findNextBucket(uint32_t bucket)
+{
+    uint32_t start = (bucket + 1) & WHEEL_MASK;
+    uint32_t word = start >> 5;
+    uint32_t bits = wheelMap[word] & (0xFFFFFFFF << (start & 31));
+    uint8_t i;
+    for (i = 0; i <= WHEEL_WORDS; i++)
+    {
+        if (bits != 0)
+        {
+            start = (word << 5) + lowestBit[((bits & -bits) * 0x077CB531) >> 27];
+            return ((start - bucket - 1) & WHEEL_MASK) + 1;
+        }
+        word = (word + 1) % WHEEL_WORDS;
+        bits = wheelMap[word];
+    }
+    return 0;
+}
+
+// Sets the match to the start of the next tick with a timer in its bucket, or one turn ahead if
+//  none is running, a match already passed is run at once from the NVIC
+void armWheel(void)
+{
+    uint32_t ticks = findNextBucket(wheelTick & WHEEL_MASK);
+    uint32_t target;
+    if (ticks == 0)
+        ticks = WHEEL_SIZE;
+    target = wheelCycles + ticks*TICK_CYCLES;
+    TIMER0_TAMATCHR_R = target;
+    if ((int32_t)(target - TIMER0_TAV_R) <= 0)
+        NVIC_SW_TRIG_R = INT_TIMER0A-16;
+}
+
+void linkTimer(uint8_t timer)
+{
+    uint32_t bucket = timers[timer].expires & WHEEL_MASK;
+    timers[timer].prev = NO_TIMER;
+    timers[timer].next = wheel[bucket];
+    if (wheel[bucket] != NO_TIMER)
+        timers[wheel[bucket]].prev = timer;
+    wheel[bucket] = timer;
+    wheelMap[bucket >> 5] |= (uint32_t)1 << (bucket & 31);
+}
+
+void unlinkTimer(uint8_t timer)
+{
+    uint32_t bucket = timers[timer].expires & WHEEL_MASK;
+    if (timers[timer].prev == NO_TIMER)
+        wheel[bucket] = timers[timer].next;
+    else
+        timers[timers[timer].prev].next = timers[timer].next;
+    if (timers[timer].next != NO_TIMER)
+        timers[timers[timer].next].prev = timers[timer].prev;
+    if (wheel[bucket] == NO_TIMER)
+        wheelMap[bucket >> 5] &= ~((uint32_t)1 << (bucket & 31));
+}
+
+// Tick of the first tick start at least ms from now, never the tick running, call with interrupts
+//  disabled
+uint32_t getExpiry(uint32_t ms)
+{
+    uint32_t ticks = (TIMER0_TAV_R - wheelCycles + (ms%TIMER_TICK_MS)*(TICK_CYCLES/TIMER_TICK_MS)
+                        + TICK_CYCLES - 1) / TICK_CYCLES + ms/TIMER_TICK_MS;
+    return wheelTick + (ticks == 0 ? 1 : ticks);
+}
+
+// (Re)starts timer to run callback ms from now, then every period ms if period is not 0
+//  safe from the main loop and from interrupts
+void startTimer(uint8_t timer, uint32_t ms, uint32_t period, TIMER_CALLBACK callback)
+{
+    uint32_t state = _disable_interrupts();
+    uint32_t expires = getExpiry(ms);
+    if (timers[timer].running)
+        unlinkTimer(timer);
+    timers[timer].expires = expires;
+    timers[timer].period = (period + TIMER_TICK_MS - 1) / TIMER_TICK_MS;
+    timers[timer].callback = callback;
+    timers[timer].running = true;
+    linkTimer(timer);
+    if (!inService)
+        armWheel();
+    _restore_interrupts(state);
+}
+
+void startOneShotTimer(uint8_t timer, uint32_t ms, TIMER_CALLBACK callback)
+{
+    startTimer(timer, ms, 0, callback);
+}
+
+// Starts timer to run callback once ms from now, a one-shot already running keeps its time if that is
+//  later, so a short run cannot cut a longer one short
+void extendOneShotTimer(uint8_t timer, uint32_t ms, TIMER_CALLBACK callback)
+{
+    uint32_t state = _disable_interrupts();
+    if (!timers[timer].running || timers[timer].period != 0
+            || (int32_t)(timers[timer].expires - getExpiry(ms)) < 0)
+        startTimer(timer, ms, 0, callback);
+    _restore_interrupts(state);
+}
+
+// periodic timers keep their phase, each run is due period ms after the last was due
+void startPeriodicTimer(uint8_t timer, uint32_t ms, TIMER_CALLBACK callback)
+{
+    startTimer(timer, ms, ms, callback);
+}
+
+// Stops timer, a stopped timer is ignored, its bucket may still cost one interrupt
+void stopTimer(uint8_t timer)
+{
+    uint32_t state = _disable_interrupts();
+    if (timers[timer].running)
+    {
+        unlinkTimer(timer);
+        timers[timer].running = false;
+    }
+    _restore_interrupts(state);
+}
+
+bool isTimerRunning(uint8_t timer)
+{
+    return timers[timer].running;
+}
+
+// Interrupts taken and callbacks run since boot
+void getTimerCounts(uint32_t* wakeups, uint32_t* callbacks)
+{
+    *wakeups = timerWakeups;
+    *callbacks = timerCallbacks;
+}
+
+// Runs the timers due on tick, one at a time as a callback may start or stop any timer
+//  periodic timers are linked again before their callback runs, call with interrupts disabled, they
+//  are restored to state around each callback
+void runBucket(uint32_t tick, uint32_t state)
+{
+    int8_t timer = wheel[tick & WHEEL_MASK];
+    TIMER_CALLBACK callback;
+    while (timer != NO_TIMER)
+    {
+        if ((int32_t)(timers[timer].expires - tick) > 0)
+        {
+            timer = timers[timer].next;
+            continue;
+        }
+        unlinkTimer(timer);
+        callback = timers[timer].callback;
+        if (timers[timer].period == 0)
+            timers[timer].running = false;
+        else
+        {
+            timers[timer].expires += timers[timer].period;
+            if ((int32_t)(timers[timer].expires - tick) <= 0)
+                timers[timer].expires = tick + timers[timer].period;
+            linkTimer(timer);
+        }
+        timerCallbacks++;
+        _restore_interrupts(state);
+        callback();
+        (void)_disable_interrupts();
+        timer = wheel[tick & WHEEL_MASK];
+    }
+}
+
+// Timer 0 match, runs every tick passed since the last one that has a timer in its bucket
+void timerServiceIsr(void)
+{
+    uint32_t state, due, ticks;
+    TIMER0_ICR_R = TIMER_ICR_TAMCINT;
+    state = _disable_interrupts();
+    timerWakeups++;
+    inService = true;
+    due = (TIMER0_TAV_R - wheelCycles) / TICK_CYCLES;
+    while (due != 0)
+    {
+        ticks = findNextBucket(wheelTick & WHEEL_MASK);
+        if (ticks == 0 || ticks > due)
+            ticks = due;
+        wheelTick += ticks;
+        wheelCycles += ticks*TICK_CYCLES;
+        due -= ticks;
+        runBucket(wheelTick, state);
+    }
+    inService = false;
+    armWheel();
+    _restore_interrupts(state);
+}
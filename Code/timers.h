@@ -0,0 +1,33 @@
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target uC:       TM4C123GH6PM
+// System Clock:    40 MHz
+
+#ifndef TIMERS_H_
+#define TIMERS_H_
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#define MAX_TIMERS          8           // software timers, numbered 0-7 by the caller
+#define TIMER_TICK_MS       100         // resolution, a timer runs up to one tick late, never early
+
+typedef void (*TIMER_CALLBACK)(void);
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void initTimers(void);
+void startOneShotTimer(uint8_t timer, uint32_t ms, TIMER_CALLBACK callback);
+void extendOneShotTimer(uint8_t timer, uint32_t ms, TIMER_CALLBACK callback);
+void startPeriodicTimer(uint8_t timer, uint32_t ms, TIMER_CALLBACK callback);
+void stopTimer(uint8_t timer);
+bool isTimerRunning(uint8_t timer);
+void getTimerCounts(uint32_t* wakeups, uint32_t* callbacks);
+void timerServiceIsr(void);
+
+#endif
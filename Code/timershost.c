@@ -0,0 +1,61 @@
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target uC:       host (POSIX)
+// System Clock:    -
+
+// Host model of Timer 0 counting up as timers.c sets it, timers.c itself runs on top of it in host
+//   builds (tm4c123gh6pmhost.h routes its register accesses here)
+// Time only moves in runTimer0: TAV counts up the given cycles, wrapping through 0xFFFFFFFF, and
+//   timerServiceIsr runs at every match on the way with TAV at the match value, as the NVIC would
+//   with no other interrupt in the way, and at once when NVIC_SW_TRIG is written
+// The plain registers are variables, nothing checks the configuration
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "tm4c123gh6pmhost.h"
+#include "timers.h"
+#include "timershost.h"
+
+#define NO_TRIGGER          0xFFFFFFFF
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+// registers, hostNvicEn0 is also in uarthost.c, the two models are not linked together
+volatile uint32_t hostRcgcTimer = 0, hostNvicEn0 = 0, hostNvicSwTrig = NO_TRIGGER;
+volatile uint32_t hostTimer0Ctl = 0, hostTimer0Cfg = 0, hostTimer0Tamr = 0, hostTimer0Tailr = 0;
+volatile uint32_t hostTimer0Tamatchr = 0, hostTimer0Imr = 0, hostTimer0Icr = 0, hostTimer0Tav = 0;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+// Moves Timer 0 on by cycles, running the service interrupt at each match passed or reached and for
+//  each software trigger
+void runTimer0(uint32_t cycles)
+{
+    uint32_t step;
+    for (;;)
+    {
+        if (hostNvicSwTrig != NO_TRIGGER)
+        {
+            hostNvicSwTrig = NO_TRIGGER;
+            timerServiceIsr();
+            continue;
+        }
+        step = hostTimer0Tamatchr - hostTimer0Tav;
+        if (step == 0 || step > cycles)
+            break;
+        hostTimer0Tav += step;
+        cycles -= step;
+        timerServiceIsr();
+    }
+    hostTimer0Tav += cycles;
+}
@@ -0,0 +1,18 @@
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target uC:       host (POSIX)
+// System Clock:    -
+
+#ifndef TIMERSHOST_H_
+#define TIMERSHOST_H_
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+// the Timer 0 model of timershost.c, these only exist in host builds
+void runTimer0(uint32_t cycles);
+
+#endif
@@ -0,0 +1,204 @@
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target uC:       host (POSIX)
+// System Clock:    -
+
+// Software timers of timers.c on the Timer 0 model
+//   first the pump of the feeder: a 1 s motion refresh during an 8 s refill must not cut the refill
+//   short, and an 8 s refill during a motion refresh must run its 8 s
+//   then random starts, stops and extensions of one-shot and periodic timers, some from inside the
+//   callbacks, over hours of Timer 0 wrapping every 107 s; every callback is checked against a
+//   reference that keeps each timer's exact due time: none early, none more than a tick late, none
+//   missed, and none from a timer that was stopped
+// usage: timerstest [steps]
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "timers.h"
+#include "timershost.h"
+
+#define DEFAULT_STEPS       200000
+#define CYCLES_PER_MS       40000       // 40 MHz
+#define TICK_CYCLES         (CYCLES_PER_MS*TIMER_TICK_MS)
+#define MAX_MS              20000       // a timer may be more than one turn of the wheel away
+#define PUMP                0
+
+// The timer as the reference sees it
+typedef struct _REFERENCE
+{
+    bool running;
+    uint64_t due;                       // cycles since the test started
+    uint64_t period;                    // cycles, 0 for a one-shot
+} REFERENCE;
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+REFERENCE reference[MAX_TIMERS];
+uint64_t start = 0;                     // time at the start of the runTimer0 running, TAV then
+uint32_t startTav = 0;
+uint64_t pumpStopped = 0;
+uint32_t runs = 0;
+bool failed = false;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void check(bool ok, const char* what)
+{
+    if (!ok && !failed)
+        printf("timerstest: FAILED %s at %llu ms\n", what, (unsigned long long)(start / CYCLES_PER_MS));
+    failed |= !ok;
+}
+
+// cycles since the test started, also inside a callback
+uint64_t getNow(void)
+{
+    return start + (uint32_t)(TIMER0_TAV_R - startTav);
+}
+
+void advance(uint64_t cycles)
+{
+    uint32_t step;
+    while (cycles != 0)
+    {
+        step = cycles > 0x40000000 ? 0x40000000 : cycles;
+        runTimer0(step);
+        start += step;
+        startTav = TIMER0_TAV_R;
+        cycles -= step;
+    }
+}
+
+void advanceMs(uint32_t ms)
+{
+    advance((uint64_t)ms * CYCLES_PER_MS);
+}
+
+void stopPump(void)
+{
+    pumpStopped = getNow();
+}
+
+// the feeder's runPump, the pump runs until pumpStopped
+void runPump(uint32_t ms)
+{
+    pumpStopped = 0;
+    extendOneShotTimer(PUMP, ms, stopPump);
+}
+
+// a start, stop or extension of a random timer at now, on the timers and on the reference
+void changeTimer(void);
+
+void ran(uint8_t timer)
+{
+    uint64_t now = getNow();
+    REFERENCE* r = &reference[timer];
+    check(r->running, "a stopped timer ran");
+    check(now >= r->due, "a timer ran early");
+    check(now - r->due <= TICK_CYCLES, "a timer ran more than a tick late");
+    if (r->period != 0)
+        r->due += r->period;
+    else
+        r->running = false;
+    runs++;
+    if (rand() % 4 == 0)
+        changeTimer();
+}
+
+void ran0(void) { ran(0); }
+void ran1(void) { ran(1); }
+void ran2(void) { ran(2); }
+void ran3(void) { ran(3); }
+void ran4(void) { ran(4); }
+void ran5(void) { ran(5); }
+void ran6(void) { ran(6); }
+void ran7(void) { ran(7); }
+
+const TIMER_CALLBACK callbacks[MAX_TIMERS] = {ran0, ran1, ran2, ran3, ran4, ran5, ran6, ran7};
+
+void changeTimer(void)
+{
+    uint8_t timer = rand() % MAX_TIMERS;
+    uint32_t ms = rand() % 4 ? rand() % MAX_MS : rand() % (2 * TIMER_TICK_MS);   // some within two ticks
+    uint64_t due = getNow() + (uint64_t)ms * CYCLES_PER_MS;
+    REFERENCE* r = &reference[timer];
+    switch (rand() % 4)
+    {
+    case 0:
+        startOneShotTimer(timer, ms, callbacks[timer]);
+        r->due = due;
+        r->period = 0;
+        break;
+    case 1:
+        ms = TIMER_TICK_MS * (1 + rand() % 50);
+        startPeriodicTimer(timer, ms, callbacks[timer]);
+        r->due = getNow() + (uint64_t)ms * CYCLES_PER_MS;
+        r->period = (uint64_t)ms * CYCLES_PER_MS;
+        break;
+    case 2:
+        stopTimer(timer);
+        r->running = false;
+        return;
+    default:
+        extendOneShotTimer(timer, ms, callbacks[timer]);
+        if (!r->running || r->period != 0 || r->due < due)
+            r->due = due;
+        r->period = 0;
+        break;
+    }
+    r->running = true;
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t steps = argc > 1 ? strtoul(argv[1], 0, 10) : DEFAULT_STEPS;
+    uint32_t step, wakeups, callbacksRun;
+    uint64_t begin;
+    uint8_t timer;
+
+    initTimers();
+
+    // a motion refresh 2 s into a refill, then a refill 500 ms into a motion refresh
+    begin = getNow();
+    runPump(8000);
+    advanceMs(2000);
+    runPump(1000);
+    advanceMs(8100 - 2000);
+    check(pumpStopped != 0 && pumpStopped - begin >= 8000 * (uint64_t)CYCLES_PER_MS
+          && pumpStopped - begin <= 8000 * (uint64_t)CYCLES_PER_MS + TICK_CYCLES, "a motion refresh shortened a refill");
+    begin = getNow();
+    runPump(1000);
+    advanceMs(500);
+    runPump(8000);
+    advanceMs(8600);
+    check(pumpStopped != 0 && pumpStopped - begin >= 8500 * (uint64_t)CYCLES_PER_MS
+          && pumpStopped - begin <= 8500 * (uint64_t)CYCLES_PER_MS + TICK_CYCLES, "a refill ended with a motion refresh");
+
+    srand(1);
+    for (step = 0; step < steps && !failed; step++)
+    {
+        advance(rand() % 4 ? rand() % (30 * TICK_CYCLES) : rand() % TICK_CYCLES);
+        for (timer = 0; timer < MAX_TIMERS; timer++)
+        {
+            check(isTimerRunning(timer) == reference[timer].running, "running differs from the reference");
+            check(!reference[timer].running || reference[timer].due + TICK_CYCLES > getNow(), "a timer missed");
+        }
+        changeTimer();
+    }
+    getTimerCounts(&wakeups, &callbacksRun);
+    printf("timerstest: %u changes over %llu s, %u callbacks checked, %u interrupts for %u callbacks%s\n", step,
+           (unsigned long long)(getNow() / CYCLES_PER_MS / 1000), runs, wakeups, callbacksRun,
+           failed ? ", FAILED" : "");
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,179 @@
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target uC:       host (POSIX)
+// System Clock:    -
+
+// Peripheral registers for host builds of the firmware modules, force included ahead of every
+//   source file (gcc -include tm4c123gh6pmhost.h) so the modules compile unchanged
+// The real header is included first, then the registers the host models implement are redefined:
+//   plain registers become variables, registers with side effects go through the model's accessors
+// The TI compiler intrinsics are defined here as well
+
+#ifndef TM4C123GH6PMHOST_H_
+#define TM4C123GH6PMHOST_H_
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "tm4c123gh6pm.h"
+
+#define _delay_cycles(cycles)   ((void)(cycles))
+// interrupts are not masked: the host tests call the isrs of the modules that disable them themselves,
+//   never inside a critical section (uarthost.c preempts uart0.c, which takes none)
+#define _disable_interrupts()   (0u)
+#define _restore_interrupts(state) ((void)(state))
+
+// EEPROM, eepromhost.c
+#undef  SYSCTL_RCGCEEPROM_R
+#undef  EEPROM_EEBLOCK_R
+#undef  EEPROM_EEOFFSET_R
+#undef  EEPROM_EERDWR_R
+#undef  EEPROM_EERDWRINC_R
+#undef  EEPROM_EEDONE_R
+#define SYSCTL_RCGCEEPROM_R     hostRcgcEeprom
+#define EEPROM_EEBLOCK_R        hostEeblock
+#define EEPROM_EEOFFSET_R       hostEeoffset
+#define EEPROM_EERDWR_R         (*accessEepromWord(false))
+#define EEPROM_EERDWRINC_R      (*accessEepromWord(true))
+#define EEPROM_EEDONE_R         (readEepromDone())
+
+// Flash controller and the staging pages, flashhost.c
+#undef  FLASH_FMA_R
+#undef  FLASH_FMD_R
+#undef  FLASH_FMC_R
+#define FLASH_FMA_R             hostFlashFma
+#define FLASH_FMD_R             hostFlashFmd
+#define FLASH_FMC_R             (*accessFlashControl())
+#define FLASH_WORD(address)     (*accessFlashWord(address))
+
+// UART0 with its pins, interrupt and uDMA channel, uarthost.c
+#undef  SYSCTL_RCGCUART_R
+#undef  SYSCTL_RCGCGPIO_R
+#undef  SYSCTL_RCGCDMA_R
+#undef  GPIO_PORTA_AFSEL_R
+#undef  GPIO_PORTA_DEN_R
+#undef  GPIO_PORTA_DR2R_R
+#undef  GPIO_PORTA_PCTL_R
+#undef  NVIC_EN0_R
+#undef  UART0_DR_R
+#undef  UART0_ECR_R
+#undef  UART0_FR_R
+#undef  UART0_IBRD_R
+#undef  UART0_FBRD_R
+#undef  UART0_LCRH_R
+#undef  UART0_CTL_R
+#undef  UART0_IFLS_R
+#undef  UART0_IM_R
+#undef  UART0_MIS_R
+#undef  UART0_ICR_R
+#undef  UART0_DMACTL_R
+#undef  UART0_CC_R
+#undef  UDMA_CFG_R
+#undef  UDMA_CTLBASE_R
+#undef  UDMA_USEBURSTCLR_R
+#undef  UDMA_REQMASKCLR_R
+#undef  UDMA_ENASET_R
+#undef  UDMA_ALTCLR_R
+#undef  UDMA_PRIOCLR_R
+#undef  UDMA_CHIS_R
+#undef  UDMA_CHMAP1_R
+#define SYSCTL_RCGCUART_R       hostRcgcUart
+#define SYSCTL_RCGCGPIO_R       hostRcgcGpio
+#define SYSCTL_RCGCDMA_R        hostRcgcDma
+#define GPIO_PORTA_AFSEL_R      hostPortAAfsel
+#define GPIO_PORTA_DEN_R        hostPortADen
+#define GPIO_PORTA_DR2R_R       hostPortADr2r
+#define GPIO_PORTA_PCTL_R       hostPortAPctl
+#define NVIC_EN0_R              hostNvicEn0
+#define UART0_DR_R              (*accessUart0Register(UART0_REG_DR))
+#define UART0_ECR_R             (*accessUart0Register(UART0_REG_ECR))
+#define UART0_FR_R              (*accessUart0Register(UART0_REG_FR))
+#define UART0_IBRD_R            hostUart0Ibrd
+#define UART0_FBRD_R            hostUart0Fbrd
+#define UART0_LCRH_R            hostUart0Lcrh
+#define UART0_CTL_R             hostUart0Ctl
+#define UART0_IFLS_R            hostUart0Ifls
+#define UART0_IM_R              hostUart0Im
+#define UART0_MIS_R             (*accessUart0Register(UART0_REG_MIS))
+#define UART0_ICR_R             (*accessUart0Register(UART0_REG_ICR))
+#define UART0_DMACTL_R          hostUart0Dmactl
+#define UART0_CC_R              hostUart0Cc
+#define UDMA_CFG_R              hostUdmaCfg
+#define UDMA_CTLBASE_R          hostUdmaCtlbase
+#define UDMA_USEBURSTCLR_R      hostUdmaUseburstclr
+#define UDMA_REQMASKCLR_R       hostUdmaReqmaskclr
+#define UDMA_ENASET_R           hostUdmaEnaset
+#define UDMA_ALTCLR_R           hostUdmaAltclr
+#define UDMA_PRIOCLR_R          hostUdmaPrioclr
+#define UDMA_CHIS_R             (*accessUart0Register(UART0_REG_CHIS))
+#define UDMA_CHMAP1_R           hostUdmaChmap1
+
+// Timer 0 and the software trigger of its interrupt, timershost.c
+#undef  SYSCTL_RCGCTIMER_R
+#undef  TIMER0_CTL_R
+#undef  TIMER0_CFG_R
+#undef  TIMER0_TAMR_R
+#undef  TIMER0_TAILR_R
+#undef  TIMER0_TAMATCHR_R
+#undef  TIMER0_IMR_R
+#undef  TIMER0_ICR_R
+#undef  TIMER0_TAV_R
+#undef  NVIC_SW_TRIG_R
+#define SYSCTL_RCGCTIMER_R      hostRcgcTimer
+#define TIMER0_CTL_R            hostTimer0Ctl
+#define TIMER0_CFG_R            hostTimer0Cfg
+#define TIMER0_TAMR_R           hostTimer0Tamr
+#define TIMER0_TAILR_R          hostTimer0Tailr
+#define TIMER0_TAMATCHR_R       hostTimer0Tamatchr
+#define TIMER0_IMR_R            hostTimer0Imr
+#define TIMER0_ICR_R            hostTimer0Icr
+#define TIMER0_TAV_R            hostTimer0Tav
+#define NVIC_SW_TRIG_R          hostNvicSwTrig
+
+// UART0 registers with side effects, see accessUart0Register
+#define UART0_REG_DR            0
+#define UART0_REG_ECR           1
+#define UART0_REG_FR            2
+#define UART0_REG_MIS           3
+#define UART0_REG_ICR           4
+#define UART0_REG_CHIS          5
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+extern volatile uint32_t hostRcgcEeprom;
+extern volatile uint32_t hostEeblock;
+extern volatile uint32_t hostEeoffset;
+
+extern volatile uint32_t hostFlashFma, hostFlashFmd;
+
+extern volatile uint32_t hostRcgcUart, hostRcgcGpio, hostRcgcDma;
+extern volatile uint32_t hostPortAAfsel, hostPortADen, hostPortADr2r, hostPortAPctl;
+extern volatile uint32_t hostNvicEn0;
+extern volatile uint32_t hostUart0Ibrd, hostUart0Fbrd, hostUart0Lcrh, hostUart0Ctl, hostUart0Ifls, hostUart0Cc;
+extern volatile uint32_t hostUart0Im, hostUart0Dmactl;
+extern volatile uint32_t hostUdmaCfg, hostUdmaCtlbase, hostUdmaUseburstclr, hostUdmaReqmaskclr, hostUdmaEnaset;
+extern volatile uint32_t hostUdmaAltclr, hostUdmaPrioclr, hostUdmaChmap1;
+
+extern volatile uint32_t hostRcgcTimer;
+extern volatile uint32_t hostTimer0Ctl, hostTimer0Cfg, hostTimer0Tamr, hostTimer0Tailr, hostTimer0Tamatchr;
+extern volatile uint32_t hostTimer0Imr, hostTimer0Icr, hostTimer0Tav;
+extern volatile uint32_t hostNvicSwTrig;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+volatile uint32_t* accessEepromWord(bool increment);
+uint32_t readEepromDone(void);
+volatile uint32_t* accessFlashControl(void);
+const volatile uint32_t* accessFlashWord(uint32_t address);
+volatile uint32_t* accessUart0Register(uint8_t reg);
+
+#endif
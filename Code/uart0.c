@@ -19,15 +19,68 @@
 #include <stdbool.h>
 #include "tm4c123gh6pm.h"
 #include "uart0.h"
+#include "cycles.h"
+#include "format.h"
 
 // PortA masks
 #define UART_TX_MASK 2
 #define UART_RX_MASK 1
 
+// Ring buffer sizes (must be powers of 2)
+#define TX_BUFFER_SIZE 512
+#define RX_BUFFER_SIZE 512
+
+// XON/XOFF software flow control, XOFF is sent when the rx ring reaches 3/4 full
+//   and XON once main has read it back down to 1/4
+#define XON  0x11
+#define XOFF 0x13
+#define RX_XOFF_LEVEL (RX_BUFFER_SIZE * 3 / 4)
+#define RX_XON_LEVEL  (RX_BUFFER_SIZE / 4)
+
+// uDMA channel 9 is UART0 TX with the default channel map
+#define TX_DMA_CHANNEL 9
+#define TX_DMA_MASK (1 << TX_DMA_CHANNEL)
+#define DMA_MAX_TRANSFER 1024
+
 //-----------------------------------------------------------------------------
 // Global variables
 //-----------------------------------------------------------------------------
 
+// Single producer / single consumer rings, each index is only written by one side
+//   tx: main writes txWriteIndex, uart0Isr writes txReadIndex
+//   rx: uart0Isr writes rxWriteIndex, main writes rxReadIndex
+char txBuffer[TX_BUFFER_SIZE];
+volatile uint16_t txWriteIndex = 0;
+volatile uint16_t txReadIndex = 0;
+char rxBuffer[RX_BUFFER_SIZE];
+volatile uint16_t rxWriteIndex = 0;
+volatile uint16_t rxReadIndex = 0;
+
+// uDMA channel control table (primary structures only), 1024 byte aligned for UDMA_CTLBASE_R
+//   each channel uses 4 words: source end pointer, destination end pointer, control word, unused
+#pragma DATA_ALIGN(dmaControlTable, 1024)
+volatile uint32_t dmaControlTable[128];
+
+// Bulk transmit state, the caller's buffer is sent in chunks of up to 1024 bytes
+volatile bool txDmaBusy = false;
+const char* txDmaNext;
+volatile uint16_t txDmaRemaining;
+void (*txDmaCallback)(void);
+
+uint32_t currentBaudRate = 115200;
+
+// Receive error counters and flow control state
+UART0_STATS rxStats;
+bool flowControl = false;
+volatile bool rxPaused = false;                      // XOFF sent, XON not yet
+volatile char flowPending = 0;                       // XON/XOFF that did not fit in the tx fifo
+
+// Throughput counters: cpu cycles spent on each transmit path and bytes sent through it
+uint32_t txRingCycles = 0;
+uint32_t txRingBytes = 0;
+uint32_t txDmaCycles = 0;
+uint32_t txDmaBytes = 0;
+
 //-----------------------------------------------------------------------------
 // Subroutines
 //-----------------------------------------------------------------------------
@@ -56,46 +109,353 @@ void initUart0()
     UART0_LCRH_R = UART_LCRH_WLEN_8 | UART_LCRH_FEN;    // configure for 8N1 w/ 16-level FIFO
     UART0_CTL_R = UART_CTL_TXE | UART_CTL_RXE | UART_CTL_UARTEN;
                                                         // enable TX, RX, and module
+
+    currentBaudRate = 115200;
+
+    // Configure UART0 interrupts to feed the ring buffers
+    txWriteIndex = txReadIndex = 0;
+    rxWriteIndex = rxReadIndex = 0;
+    rxStats.overrun = rxStats.framing = rxStats.parity = rxStats.breaks = rxStats.dropped = rxStats.xoff = 0;
+    flowControl = false;
+    rxPaused = false;
+    flowPending = 0;
+    UART0_IFLS_R = UART_IFLS_TX4_8 | UART_IFLS_RX4_8;   // interrupt at half full rx / half empty tx
+    UART0_IM_R = UART_IM_RXIM | UART_IM_RTIM;           // rx and rx timeout, tx enabled when data is queued
+    NVIC_EN0_R = 1 << (INT_UART0-16);                   // turn-on interrupt 21 (UART0) in NVIC
+
+    // Configure uDMA channel 9 for bulk transmits
+    SYSCTL_RCGCDMA_R |= SYSCTL_RCGCDMA_R0;
+    _delay_cycles(3);
+    UDMA_CFG_R = UDMA_CFG_MASTEN;                       // enable uDMA controller
+    UDMA_CTLBASE_R = (uint32_t)dmaControlTable;
+    UDMA_CHMAP1_R &= ~0x000000F0;                       // channel 9 assigned to UART0 TX (encoding 0)
+    UDMA_PRIOCLR_R = TX_DMA_MASK;                       // default priority
+    UDMA_ALTCLR_R = TX_DMA_MASK;                        // use primary control structure
+    UDMA_USEBURSTCLR_R = TX_DMA_MASK;                   // respond to single and burst requests
+    UDMA_REQMASKCLR_R = TX_DMA_MASK;                    // allow UART0 to request transfers
+    txDmaBusy = false;
 }
 
-// Set baud rate as function of instruction cycle frequency
-void setUart0BaudRate(uint32_t baudRate, uint32_t fcyc)
+// Calculates the divisor for baudRate in units of 1/64 and whether high speed (8x) mode is needed
+//   returns the baud rate the divisor actually produces, 0 if baudRate is out of reach of fcyc
+uint32_t calcUart0BaudRate(uint32_t baudRate, uint32_t fcyc, uint32_t* divisorTimes64, bool* highSpeed)
 {
-    uint32_t divisorTimes128 = (fcyc * 8) / baudRate;   // calculate divisor (r) in units of 1/128,
-                                                        // where r = fcyc / 16 * baudRate
+    uint32_t divisorTimes128;
+    uint32_t clocksPerBit;
+    if (baudRate == 0 || baudRate > fcyc / 8)
+        return 0;
+    *highSpeed = baudRate > fcyc / 16;                  // 16x oversampling no longer reaches, use 8x
+    clocksPerBit = *highSpeed ? 8 : 16;
+    divisorTimes128 = (fcyc * (128 / clocksPerBit)) / baudRate;
+                                                        // calculate divisor (r) in units of 1/128,
+                                                        // where r = fcyc / N * baudRate
     divisorTimes128 += 1;                               // add 1/128 to allow rounding
+    *divisorTimes64 = divisorTimes128 >> 1;
+    if ((*divisorTimes64 >> 6) > 0xFFFF)
+        return 0;
+    return (fcyc * (64 / clocksPerBit)) / *divisorTimes64;
+}
+
+// Returns the error of an achieved baud rate against baudRate in units of 0.01 %, 0 if actual is 0
+int32_t calcUart0BaudError(uint32_t baudRate, uint32_t actual)
+{
+    return actual ? (int32_t)(((int64_t)actual - baudRate) * 10000 / baudRate) : 0;
+}
+
+// Set baud rate as function of instruction cycle frequency
+//   waits for queued output to go out first, returns the achieved baud rate (0 if not possible and
+//   nothing changed)
+uint32_t setUart0BaudRate(uint32_t baudRate, uint32_t fcyc)
+{
+    uint32_t divisorTimes64;
+    bool highSpeed;
+    uint32_t actual = calcUart0BaudRate(baudRate, fcyc, &divisorTimes64, &highSpeed);
+    if (actual == 0)
+        return 0;
+    while ((txReadIndex != txWriteIndex) || txDmaBusy);  // let queued characters go out at the old rate
+    while (UART0_FR_R & UART_FR_BUSY);
     UART0_CTL_R = 0;                                    // turn-off UART0 to allow safe programming
-    UART0_IBRD_R = divisorTimes128 >> 7;                // set integer value to floor(r)
-    UART0_FBRD_R = ((divisorTimes128) >> 1) & 63;       // set fractional value to round(fract(r)*64)
+    UART0_IBRD_R = divisorTimes64 >> 6;                 // set integer value to floor(r)
+    UART0_FBRD_R = divisorTimes64 & 63;                 // set fractional value to round(fract(r)*64)
     UART0_LCRH_R = UART_LCRH_WLEN_8 | UART_LCRH_FEN;    // configure for 8N1 w/ 16-level FIFO
-    UART0_CTL_R = UART_CTL_TXE | UART_CTL_RXE | UART_CTL_UARTEN;
+    UART0_CTL_R = UART_CTL_TXE | UART_CTL_RXE | UART_CTL_UARTEN | (highSpeed ? UART_CTL_HSE : 0);
                                                         // turn-on UART0
+    currentBaudRate = actual;
+    return actual;
+}
+
+// Returns the baud rate last set by setUart0BaudRate (115200 after initUart0)
+uint32_t getUart0BaudRate()
+{
+    return currentBaudRate;
+}
+
+// Discards everything waiting in the rx ring
+void flushUart0Rx()
+{
+    rxReadIndex = rxWriteIndex;
+}
+
+
+// Sends XON or XOFF ahead of everything queued, the fifo only holds it back behind at most 16 characters
+void sendFlowControl(char c)
+{
+    if (!(UART0_FR_R & UART_FR_TXFF))
+        UART0_DR_R = c;
+    else
+    {
+        flowPending = c;                             // sent by the next fillTxFifo
+        UART0_IM_R |= UART_IM_TXIM;
+    }
+}
+
+// Turns XON/XOFF flow control of the rx ring on or off (off after initUart0)
+//   keep it off while binary data is sent, the host would take 0x11/0x13 in a frame as flow control
+void setUart0FlowControl(bool enable)
+{
+    flowControl = enable;
+    if (!enable && rxPaused)
+    {
+        rxPaused = false;
+        sendFlowControl(XON);
+    }
+}
+
+bool getUart0FlowControl()
+{
+    return flowControl;
 }
 
-// Blocking function that writes a serial character when the UART buffer is not full
+// Copies the receive error counters
+void getUart0Stats(UART0_STATS* stats)
+{
+    *stats = rxStats;
+}
+
+// Moves queued characters into the tx fifo until the fifo is full or the ring is empty
+//   must only be called from uart0Isr or with the tx interrupt masked
+void fillTxFifo()
+{
+    if (flowPending && !(UART0_FR_R & UART_FR_TXFF))
+    {
+        UART0_DR_R = flowPending;
+        flowPending = 0;
+    }
+    if (txDmaBusy)                                   // uDMA owns the fifo until its transfer completes
+        return;
+    while (!(UART0_FR_R & UART_FR_TXFF) && (txReadIndex != txWriteIndex))
+    {
+        UART0_DR_R = txBuffer[txReadIndex];
+        txReadIndex = (txReadIndex + 1) & (TX_BUFFER_SIZE - 1);
+    }
+}
+
+// Starts transmission of queued characters if the tx interrupt is not already draining them
+//   while uDMA owns the fifo the tx interrupt stays off, the completion restarts it
+void primeTxFifo()
+{
+    UART0_IM_R &= ~UART_IM_TXIM;                     // keep uart0Isr away from txReadIndex
+    fillTxFifo();
+    if (!txDmaBusy)
+        UART0_IM_R |= UART_IM_TXIM;
+}
+
+// Non-blocking function that queues a serial character, returns false if the tx ring is full
+bool putcUart0NonBlocking(char c)
+{
+    uint16_t next = (txWriteIndex + 1) & (TX_BUFFER_SIZE - 1);
+    if (next == txReadIndex)
+        return false;
+    txBuffer[txWriteIndex] = c;
+    txWriteIndex = next;
+    primeTxFifo();
+    return true;
+}
+
+// Non-blocking function that queues as much of a string as fits, returns the number of characters queued
+uint16_t putsUart0NonBlocking(const char* str)
+{
+    uint16_t i = 0;
+    uint16_t next;
+    while (str[i] != '\0')
+    {
+        next = (txWriteIndex + 1) & (TX_BUFFER_SIZE - 1);
+        if (next == txReadIndex)
+            break;
+        txBuffer[txWriteIndex] = str[i++];
+        txWriteIndex = next;
+    }
+    primeTxFifo();
+    return i;
+}
+
+// Blocking function that queues a serial character, waits only when the tx ring is full
 void putcUart0(char c)
 {
-    while (UART0_FR_R & UART_FR_TXFF);               // wait if uart0 tx fifo full
-    UART0_DR_R = c;                                  // write character to fifo
+    while (!putcUart0NonBlocking(c));
 }
 
-// Blocking function that writes a string when the UART buffer is not full
+// Blocking function that queues a string, waits only when the tx ring is full
 void putsUart0(char* str)
 {
-    uint8_t i = 0;
+    uint32_t start = readCycleCounter();
+    uint16_t i = 0;
     while (str[i] != '\0')
-        putcUart0(str[i++]);
+        i += putsUart0NonBlocking(&str[i]);
+    txRingCycles += readCycleCounter() - start;
+    txRingBytes += i;
+}
+
+// Writes value in decimal, zero padded to at least width digits, see formatUnsigned
+void putuUart0(uint32_t value, uint8_t width)
+{
+    char digits[11];
+    *formatUnsigned(digits, value, width) = '\0';
+    putsUart0(digits);
 }
 
-// Blocking function that returns with serial data once the buffer is not empty
+// Programs the next chunk of the bulk transmit into channel 9 and enables uart0 tx dma requests
+void startTxDmaChunk()
+{
+    uint16_t count = txDmaRemaining;
+    if (count > DMA_MAX_TRANSFER)
+        count = DMA_MAX_TRANSFER;
+    dmaControlTable[TX_DMA_CHANNEL*4+0] = (uint32_t)(txDmaNext + count - 1);
+    dmaControlTable[TX_DMA_CHANNEL*4+1] = (uint32_t)&UART0_DR_R;
+    dmaControlTable[TX_DMA_CHANNEL*4+2] = UDMA_CHCTL_DSTINC_NONE | UDMA_CHCTL_DSTSIZE_8 | UDMA_CHCTL_SRCINC_8
+                                        | UDMA_CHCTL_SRCSIZE_8 | UDMA_CHCTL_ARBSIZE_4
+                                        | ((count - 1) << UDMA_CHCTL_XFERSIZE_S) | UDMA_CHCTL_XFERMODE_BASIC;
+    txDmaNext += count;
+    txDmaRemaining -= count;
+    UDMA_ENASET_R = TX_DMA_MASK;
+    UART0_DMACTL_R |= UART_DMACTL_TXDMAE;
+}
+
+// Non-blocking bulk transmit of length bytes straight from buffer (no copy) using uDMA
+//   buffer must stay untouched until callback runs (from uart0Isr), callback may be 0
+//   returns false if a bulk transmit is already in progress
+bool putsUart0Dma(const char* buffer, uint16_t length, void (*callback)(void))
+{
+    uint32_t start;
+    if (txDmaBusy)
+        return false;
+    if (length == 0)
+    {
+        if (callback)
+            callback();
+        return true;
+    }
+    while (txReadIndex != txWriteIndex);             // let previously queued characters go out first
+    start = readCycleCounter();
+    txDmaNext = buffer;
+    txDmaRemaining = length;
+    txDmaCallback = callback;
+    UART0_IM_R &= ~UART_IM_TXIM;                     // fifo level changes are uDMA's until it completes
+    txDmaBusy = true;
+    startTxDmaChunk();
+    txDmaCycles += readCycleCounter() - start;
+    txDmaBytes += length;
+    return true;
+}
+
+// Returns average cpu cycles spent per byte sent through the ring (putsUart0) path
+uint32_t getUart0RingCyclesPerByte()
+{
+    return txRingBytes ? txRingCycles / txRingBytes : 0;
+}
+
+// Returns average cpu cycles spent per byte sent through the uDMA (putsUart0Dma) path
+uint32_t getUart0DmaCyclesPerByte()
+{
+    return txDmaBytes ? txDmaCycles / txDmaBytes : 0;
+}
+
+// Blocking function that returns with serial data once the rx ring is not empty
 char getcUart0()
 {
-    while (UART0_FR_R & UART_FR_RXFE);               // wait if uart0 rx fifo empty
-    return UART0_DR_R & 0xFF;                        // get character from fifo
+    char c;
+    while (rxReadIndex == rxWriteIndex);             // wait if rx ring empty
+    c = rxBuffer[rxReadIndex];
+    rxReadIndex = (rxReadIndex + 1) & (RX_BUFFER_SIZE - 1);
+    if (rxPaused && ((rxWriteIndex - rxReadIndex) & (RX_BUFFER_SIZE - 1)) <= RX_XON_LEVEL)
+    {
+        UART0_IM_R &= ~(UART_IM_RXIM | UART_IM_RTIM);   // keep uart0Isr from sending XOFF in between
+        rxPaused = false;
+        sendFlowControl(XON);
+        UART0_IM_R |= UART_IM_RXIM | UART_IM_RTIM;
+    }
+    return c;
 }
 
-// Returns the status of the receive buffer
+// Returns the status of the receive ring
 bool kbhitUart0()
 {
-    return !(UART0_FR_R & UART_FR_RXFE);
+    return rxReadIndex != rxWriteIndex;
+}
+
+// Moves received characters into the rx ring and refills the tx fifo from the tx ring
+void uart0Isr()
+{
+    uint16_t next;
+    uint32_t status = UART0_MIS_R;
+    UART0_ICR_R = status;                            // clear the interrupts being serviced
+
+    while (!(UART0_FR_R & UART_FR_RXFE))
+    {
+        uint32_t data = UART0_DR_R;                  // error flags come with the character
+        if (data & UART_DR_OE)
+            rxStats.overrun++;                       // characters were lost before this one
+        if (data & UART_DR_BE)
+            rxStats.breaks++;
+        else if (data & UART_DR_FE)
+            rxStats.framing++;
+        if (data & UART_DR_PE)
+            rxStats.parity++;
+        if (data & (UART_DR_BE | UART_DR_FE | UART_DR_PE))
+            continue;                                // do not pass corrupted characters on
+        next = (rxWriteIndex + 1) & (RX_BUFFER_SIZE - 1);
+        if (next != rxReadIndex)                     // drop character if rx ring is full
+        {
+            rxBuffer[rxWriteIndex] = data & 0xFF;
+            rxWriteIndex = next;
+        }
+        else
+            rxStats.dropped++;
+    }
+    UART0_ECR_R = 0;                                 // clear latched errors
+
+    if (flowControl && !rxPaused && ((rxWriteIndex - rxReadIndex) & (RX_BUFFER_SIZE - 1)) >= RX_XOFF_LEVEL)
+    {
+        rxPaused = true;
+        rxStats.xoff++;
+        sendFlowControl(XOFF);
+    }
+
+    if (UDMA_CHIS_R & TX_DMA_MASK)                   // uDMA completion is signaled on the UART0 vector
+    {
+        uint32_t start = readCycleCounter();
+        UDMA_CHIS_R = TX_DMA_MASK;
+        if (txDmaRemaining)
+        {
+            startTxDmaChunk();
+        }
+        else
+        {
+            UART0_DMACTL_R &= ~UART_DMACTL_TXDMAE;
+            txDmaBusy = false;
+            if (txDmaCallback)
+                txDmaCallback();
+            fillTxFifo();                            // resume characters queued during the transfer
+            if (txReadIndex != txWriteIndex)
+                UART0_IM_R |= UART_IM_TXIM;
+        }
+        txDmaCycles += readCycleCounter() - start;
+    }
+
+    if (status & UART_MIS_TXMIS)
+    {
+        fillTxFifo();
+        if (!flowPending && (txDmaBusy || txReadIndex == txWriteIndex))
+            UART0_IM_R &= ~UART_IM_TXIM;             // nothing left to send, or only uDMA sends now
+    }
 }
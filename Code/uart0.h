@@ -18,15 +18,39 @@
 #ifndef UART0_H_
 #define UART0_H_
 
+typedef struct _UART0_STATS
+{
+    uint32_t overrun;               // rx fifo overruns (characters lost in hardware)
+    uint32_t framing;
+    uint32_t parity;
+    uint32_t breaks;
+    uint32_t dropped;               // characters lost because the rx ring was full
+    uint32_t xoff;                  // times XOFF was sent
+} UART0_STATS;
+
 //-----------------------------------------------------------------------------
 // Subroutines
 //-----------------------------------------------------------------------------
 
 void initUart0();
-void setUart0BaudRate(uint32_t baudRate, uint32_t fcyc);
+uint32_t calcUart0BaudRate(uint32_t baudRate, uint32_t fcyc, uint32_t* divisorTimes64, bool* highSpeed);
+int32_t calcUart0BaudError(uint32_t baudRate, uint32_t actual);
+uint32_t setUart0BaudRate(uint32_t baudRate, uint32_t fcyc);
+uint32_t getUart0BaudRate();
+void flushUart0Rx();
+void setUart0FlowControl(bool enable);
+bool getUart0FlowControl();
+void getUart0Stats(UART0_STATS* stats);
+bool putcUart0NonBlocking(char c);
+uint16_t putsUart0NonBlocking(const char* str);
 void putcUart0(char c);
 void putsUart0(char* str);
+void putuUart0(uint32_t value, uint8_t width);
+bool putsUart0Dma(const char* buffer, uint16_t length, void (*callback)(void));
+uint32_t getUart0RingCyclesPerByte();
+uint32_t getUart0DmaCyclesPerByte();
 char getcUart0();
 bool kbhitUart0();
+void uart0Isr();
 
 #endif
@@ -0,0 +1,51 @@
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target uC:       host (POSIX)
+// System Clock:    -
+
+// Host stand-in for the receive side of uart0.h used by parser.c
+//   kbhitUart0/getcUart0 return the characters of the buffer given to setUart0StubInput
+//   instead of the rx ring, so the line assembler runs without the UART model
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "uart0.h"
+#include "uart0stub.h"
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+const char* stubInput = 0;
+uint32_t stubLength = 0;
+uint32_t stubIndex = 0;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void setUart0StubInput(const char* input, uint32_t length)
+{
+    stubInput = input;
+    stubLength = length;
+    stubIndex = 0;
+}
+
+bool kbhitUart0()
+{
+    return stubIndex < stubLength;
+}
+
+// returns 0 once the input is used up, kbhitUart0 tells when that is
+char getcUart0()
+{
+    if (stubIndex >= stubLength)
+        return 0;
+    return stubInput[stubIndex++];
+}
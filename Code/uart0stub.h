@@ -0,0 +1,18 @@
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target uC:       host (POSIX)
+// System Clock:    -
+
+#ifndef UART0STUB_H_
+#define UART0STUB_H_
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+// uart0.h receive functions are implemented by uart0stub.c in parser host builds, this only exists there
+void setUart0StubInput(const char* input, uint32_t length);
+
+#endif
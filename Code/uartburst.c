@@ -0,0 +1,283 @@
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target uC:       host (POSIX)
+// System Clock:    -
+
+// 10 KB bursts through the uart0.c rings on the UART0 model of uarthost.c, in real line time
+//   tx: putsUart0 and putsUart0NonBlocking, reports bytes/s on the line and how long the calls took,
+//       the time the caller was blocked, as 99th percentile and longest (host scheduling included)
+//       then putsUart0Dma with a line queued on the ring during the transfer, which must follow it,
+//       and only the uDMA completions may interrupt while it runs
+//   rx: command lines sent back to back, assembled by getsUart0NonBlocking, then again with the
+//       main loop stalling every few lines and XON/XOFF keeping the rx ring from overflowing
+//   any character lost, changed or out of order fails the run
+// usage: uartburst [baud]
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "uart0.h"
+#include "parser.h"
+#include "uarthost.h"
+
+#define BURST_SIZE          10240
+#define LINE_SIZE           64          // 160 lines of 62 characters and CR LF
+#define STALL_LINES         16          // lines between stalls of the flow control run
+#define STALL_NS            40000000    // 40 ms, the rx ring holds 44 ms at 115200 baud
+#define DMA_INTERRUPTS      16          // one per 1 KB chunk completed and a few to spare
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+char burst[BURST_SIZE+1];
+uint32_t callTimes[64];                 // calls by log2 of their ns, for the 99th percentile
+char received[BURST_SIZE];
+volatile bool dmaFinished;
+bool failed = false;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+uint64_t nowNs(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec * 1000000000 + t.tv_nsec;
+}
+
+void sleepNs(uint64_t ns)
+{
+    struct timespec t = {ns / 1000000000, ns % 1000000000};
+    while (nanosleep(&t, &t) != 0);
+}
+
+void countCall(uint64_t ns)
+{
+    uint8_t bucket = 0;
+    while (ns >> bucket > 1 && bucket < 63)
+        bucket++;
+    callTimes[bucket]++;
+}
+
+// Upper bound of the 99th percentile call time in ns, and clears the counts
+uint64_t getCallPercentile99(void)
+{
+    uint64_t total = 0, seen = 0;
+    uint8_t bucket, i;
+    for (i = 0; i < 64; i++)
+        total += callTimes[i];
+    for (bucket = 0; bucket < 63 && (seen += callTimes[bucket]) * 100 < total * 99; bucket++);
+    for (i = 0; i < 64; i++)
+        callTimes[i] = 0;
+    return (uint64_t)2 << bucket;
+}
+
+// ns as text in the unit that suits it, one of two static buffers so two can go in one printf
+const char* showNs(uint64_t ns)
+{
+    static char text[2][16];
+    static uint8_t which = 0;
+    which ^= 1;
+    if (ns < 10000)
+        snprintf(text[which], 16, "%u ns", (unsigned)ns);
+    else if (ns < 10000000)
+        snprintf(text[which], 16, "%.1f us", ns / 1e3);
+    else
+        snprintf(text[which], 16, "%.1f ms", ns / 1e6);
+    return text[which];
+}
+
+void check(bool ok, const char* what)
+{
+    if (!ok)
+    {
+        printf("uartburst: FAILED %s\n", what);
+        failed = true;
+    }
+}
+
+// Lines of printable characters ending in CR LF, numbered so a lost line shows
+void makeBurst(void)
+{
+    uint16_t line, i;
+    for (line = 0; line < BURST_SIZE / LINE_SIZE; line++)
+    {
+        char* p = &burst[line * LINE_SIZE];
+        sprintf(p, "%04u ", line);
+        for (i = 5; i < LINE_SIZE - 2; i++)
+            p[i] = 'a' + (line + i) % 26;
+        p[LINE_SIZE - 2] = 13;
+        p[LINE_SIZE - 1] = 10;
+    }
+    burst[BURST_SIZE] = 0;
+}
+
+// Collects what the host received until BURST_SIZE characters are in, returns the time the last came
+uint64_t collectTx(uint32_t* count)
+{
+    uint64_t last = nowNs();
+    while (*count < BURST_SIZE && nowNs() - last < 1000000000)
+    {
+        uint32_t n = receiveFromUart0(&received[*count], BURST_SIZE - *count);
+        if (n)
+        {
+            *count += n;
+            last = nowNs();
+        }
+        else
+            sleepNs(100000);
+    }
+    return last;
+}
+
+void testTx(bool blocking, uint32_t baud)
+{
+    uint64_t start, end, call, longest = 0;
+    uint32_t count = 0, sent = 0, loops = 0;
+    char line[LINE_SIZE+1];
+    start = nowNs();
+    while (sent < BURST_SIZE)
+    {
+        if (blocking)
+        {
+            memcpy(line, &burst[sent], LINE_SIZE);
+            line[LINE_SIZE] = 0;
+            call = nowNs();
+            putsUart0(line);
+            call = nowNs() - call;
+            sent += LINE_SIZE;
+        }
+        else
+        {
+            call = nowNs();
+            sent += putsUart0NonBlocking(&burst[sent]);
+            call = nowNs() - call;
+            count += receiveFromUart0(&received[count], BURST_SIZE - count);
+            loops++;                        // the main loop is free to do other work here
+        }
+        countCall(call);
+        if (call > longest)
+            longest = call;
+    }
+    end = collectTx(&count);
+    check(count == BURST_SIZE && memcmp(received, burst, BURST_SIZE) == 0, "tx data");
+    printf("tx %s: %u bytes in %.1f ms, %.0f bytes/s (line %.0f), calls 99%% under %s, longest %s%s",
+           blocking ? "putsUart0" : "putsUart0NonBlocking", count, (end - start) / 1e6,
+           count / ((end - start) / 1e9), baud / 10.0, showNs(getCallPercentile99()), showNs(longest),
+           blocking ? "\n" : "");
+    if (!blocking)
+        printf(", %u main loop passes\n", loops);
+}
+
+void dmaDone(void)
+{
+    dmaFinished = true;
+}
+
+// One uDMA bulk transmit of the burst but its last line, which is queued on the ring while the transfer
+//  runs, the ring must wait for it and the tx interrupt must stay off, only completions interrupt
+void testDma(uint32_t baud)
+{
+    UART_HOST_STATS before, after;
+    uint64_t start, end;
+    uint32_t count = 0;
+    char line[LINE_SIZE+1];
+    memcpy(line, &burst[BURST_SIZE - LINE_SIZE], LINE_SIZE);
+    line[LINE_SIZE] = 0;
+    dmaFinished = false;
+    getUartHostStats(&before);
+    start = nowNs();
+    check(putsUart0Dma(burst, BURST_SIZE - LINE_SIZE, dmaDone), "uDMA transmit started");
+    check(putsUart0NonBlocking(line) == LINE_SIZE, "line queued during the transfer");
+    while (!dmaFinished && nowNs() - start < 2000000000)
+        count += receiveFromUart0(&received[count], BURST_SIZE - count);
+    getUartHostStats(&after);
+    end = collectTx(&count);
+    check(count == BURST_SIZE && memcmp(received, burst, BURST_SIZE) == 0, "uDMA tx data");
+    check(after.interrupts - before.interrupts <= DMA_INTERRUPTS, "interrupts during the uDMA transfer");
+    printf("tx putsUart0Dma: %u bytes in %.1f ms, %.0f bytes/s (line %.0f), %u interrupts during the transfer\n",
+           count, (end - start) / 1e6, count / ((end - start) / 1e9), baud / 10.0,
+           after.interrupts - before.interrupts);
+}
+
+void testRx(bool stall, uint32_t baud)
+{
+    USER_DATA data;
+    UART0_STATS stats;
+    uint64_t start, end, longest = 0, call;
+    uint32_t lines = 0, bytes = 0;
+    char expected[LINE_SIZE];
+    data.charCount = 0;
+    flushUart0Rx();
+    setUart0FlowControl(stall);
+    setUartHostFlowControl(stall);
+    start = nowNs();
+    sendToUart0(burst, BURST_SIZE);
+    end = start;
+    while (lines < BURST_SIZE / LINE_SIZE && nowNs() - end < 2000000000)
+    {
+        call = nowNs();
+        if (getsUart0NonBlocking(&data))    // the LF after each CR is not printable and is dropped
+        {
+            memcpy(expected, &burst[lines * LINE_SIZE], LINE_SIZE - 2);
+            expected[LINE_SIZE - 2] = 0;
+            check(strcmp(data.buffer, expected) == 0, "rx line");
+            bytes += LINE_SIZE;
+            lines++;
+            end = nowNs();
+            if (stall && lines % STALL_LINES == 0)
+                sleepNs(STALL_NS);
+        }
+        call = nowNs() - call;
+        if (stall && lines % STALL_LINES == 0)
+            continue;                       // the stall, not the call
+        countCall(call);
+        if (call > longest)
+            longest = call;
+    }
+    getUart0Stats(&stats);
+    check(lines == BURST_SIZE / LINE_SIZE, "rx line count");
+    check(stats.dropped == 0 && stats.overrun == 0, "rx characters lost");
+    if (stall)
+        check(stats.xoff != 0, "XOFF sent");
+    printf("rx %s: %u bytes in %.1f ms, %.0f bytes/s (line %.0f), getsUart0NonBlocking 99%% under %s, "
+           "longest %s, %u dropped, %u overruns, %u XOFF\n",
+           stall ? "stalling every 16 lines with flow control" : "back to back", bytes, (end - start) / 1e6,
+           bytes / ((end - start) / 1e9), baud / 10.0, showNs(getCallPercentile99()), showNs(longest),
+           stats.dropped, stats.overrun, stats.xoff);
+    setUart0FlowControl(false);
+    setUartHostFlowControl(false);
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t baud = 115200;
+    UART_HOST_STATS host;
+    makeBurst();
+    startUartHost(false);
+    initUart0();
+    if (argc > 1)
+        baud = setUart0BaudRate(strtoul(argv[1], 0, 10), 40000000);
+    printf("uartburst: %u byte bursts at %u baud\n", BURST_SIZE, baud);
+    testTx(true, baud);
+    testTx(false, baud);
+    testDma(baud);
+    testRx(false, baud);
+    testRx(true, baud);
+    stopUartHost();
+    getUartHostStats(&host);
+    printf("uartburst: %u interrupts, %u rx fifo overruns%s\n", host.interrupts, host.rxOverruns,
+           failed ? ", FAILED" : "");
+    return failed ? 1 : 0;
+}
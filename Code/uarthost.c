@@ -0,0 +1,457 @@
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target uC:       host (POSIX)
+// System Clock:    -
+
+// Host model of UART0, its 16 byte fifos, its interrupt and uDMA channel 9, uart0.c itself runs on
+//   top of it in host builds (tm4c123gh6pmhost.h routes its register accesses here)
+// A device thread moves one character each way per character time of the baud rate set in
+//   IBRD/FBRD/HSE, in real time, so the rings, the interrupt handler and the line assembler see the
+//   same timing as on the board
+//   tx: the uDMA channel, when enabled, keeps the tx fifo full, then the oldest character goes out
+//       to the host side (or back into the rx fifo in loopback)
+//   rx: the next character the host side sent goes into the rx fifo, a full fifo loses it and the
+//       next character read carries OE; a host honoring flow control stops at XOFF until XON
+//       while the fifo is full with its interrupt enabled and pending the line waits instead, the
+//       handler is late only because the host did not schedule the thread, the board takes it in
+//       microseconds
+//   interrupts: RXRIS at 8 characters, RTRIS after 4 idle character times with data waiting,
+//       TXRIS when the tx fifo drains to 8, and uDMA completion on the same vector
+// The interrupt is a SIGUSR1 sent to the thread that called startUartHost, its handler runs
+//   uart0Isr while an enabled interrupt is pending, preempting that thread as on the board
+//   the device thread sends it on every character time with an interrupt pending, so unmasking
+//   IM takes effect within one character time
+// Register accesses take a mutex with SIGUSR1 blocked, so they are atomic to both the device thread
+//   and the handler
+// DR, ECR, ICR and CHIS return a latch of the accessing context (thread or handler) with bit 31
+//   set, a store clears it, and the device thread or the next access of that context carries the
+//   store out, a DR access right after FR showed data in the handler that is not stored to reads the
+//   character, as uart0Isr does (only the handler reads DR)
+// uDMA source addresses are truncated to 32 bits, so the programs link with -no-pie and transmit
+//   from static buffers
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <signal.h>
+#include <time.h>
+#include "tm4c123gh6pmhost.h"
+#include "uart0.h"
+#include "uarthost.h"
+
+#define FIFO_SIZE           16
+#define HOST_BUFFER_SIZE    65536       // each direction, must be a power of 2
+#define LATCH_OPEN          0x80000000  // bit 31 of a latch until the code stores to it
+#define TX_DMA_CHANNEL      9
+#define TX_DMA_MASK         (1 << TX_DMA_CHANNEL)
+#define RX_TIMEOUT_CHARS    4           // 32 bit times rounded up
+#define MAX_CATCH_UP        16          // character times run at once after a late wake up
+#define XON                 0x11
+#define XOFF                0x13
+
+typedef struct _FIFO
+{
+    uint16_t data[FIFO_SIZE];           // rx entries carry the DR error bits
+    uint8_t head;
+    uint8_t count;
+} FIFO;
+
+typedef struct _LATCH
+{
+    volatile uint32_t value;
+    uint8_t reg;
+    bool open;
+    bool armed;                         // FR showed rx data, the next DR access reads it
+    bool reading;                       // DR access made armed
+} LATCH;
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+// registers
+volatile uint32_t hostRcgcUart = 0, hostRcgcGpio = 0, hostRcgcDma = 0;
+volatile uint32_t hostPortAAfsel = 0, hostPortADen = 0, hostPortADr2r = 0, hostPortAPctl = 0;
+volatile uint32_t hostNvicEn0 = 0;
+volatile uint32_t hostUart0Ibrd = 0, hostUart0Fbrd = 0, hostUart0Lcrh = 0, hostUart0Ctl = 0;
+volatile uint32_t hostUart0Ifls = 0, hostUart0Cc = 0, hostUart0Im = 0, hostUart0Dmactl = 0;
+volatile uint32_t hostUdmaCfg = 0, hostUdmaCtlbase = 0, hostUdmaUseburstclr = 0, hostUdmaReqmaskclr = 0;
+volatile uint32_t hostUdmaEnaset = 0, hostUdmaAltclr = 0, hostUdmaPrioclr = 0, hostUdmaChmap1 = 0;
+
+FIFO txFifo, rxFifo;
+uint32_t ris = 0;
+uint32_t chis = 0;
+bool overrunNext = false;               // a character was lost, the next one read carries OE
+uint32_t idleChars = 0;                 // character times since the last character received
+
+LATCH threadLatch, handlerLatch;
+volatile sig_atomic_t inHandler = 0;
+
+pthread_mutex_t modelMutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_t cpuThread, deviceThread;
+volatile bool running = false;
+bool loopback = false;
+
+// host side of the line
+char toDevice[HOST_BUFFER_SIZE];
+uint32_t toDeviceWrite = 0, toDeviceRead = 0;
+char fromDevice[HOST_BUFFER_SIZE];
+uint32_t fromDeviceWrite = 0, fromDeviceRead = 0;
+bool hostFlowControl = false;
+bool hostPaused = false;                // XOFF received
+UART_HOST_STATS hostStats;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void pushFifo(FIFO* fifo, uint16_t data)
+{
+    fifo->data[(fifo->head + fifo->count) % FIFO_SIZE] = data;
+    fifo->count++;
+}
+
+uint16_t popFifo(FIFO* fifo)
+{
+    uint16_t data = fifo->data[fifo->head];
+    fifo->head = (fifo->head + 1) % FIFO_SIZE;
+    fifo->count--;
+    return data;
+}
+
+// Trigger levels of IFLS, in characters
+uint8_t getRxTrigger(void)
+{
+    static const uint8_t levels[5] = {2, 4, 8, 12, 14};
+    uint8_t level = (hostUart0Ifls >> 3) & 7;
+    return level < 5 ? levels[level] : 8;
+}
+
+uint8_t getTxTrigger(void)
+{
+    static const uint8_t levels[5] = {14, 12, 8, 4, 2};
+    uint8_t level = hostUart0Ifls & 7;
+    return level < 5 ? levels[level] : 8;
+}
+
+// A character written to DR, TXRIS clears once the fifo is filled above the trigger level
+void transmitCharacter(uint8_t c)
+{
+    if (txFifo.count == FIFO_SIZE)
+    {
+        hostStats.txLost++;
+        return;
+    }
+    pushFifo(&txFifo, c);
+    if (txFifo.count > getTxTrigger())
+        ris &= ~UART_RIS_TXRIS;
+}
+
+// Carries out a store to a latch, from any thread, a store is final once made
+void syncLatch(LATCH* latch)
+{
+    uint32_t value = latch->value;
+    if (!latch->open || (value & LATCH_OPEN))
+        return;
+    latch->open = false;
+    switch (latch->reg)
+    {
+    case UART0_REG_DR:
+        transmitCharacter(value);
+        break;
+    case UART0_REG_ICR:
+        ris &= ~value;
+        break;
+    case UART0_REG_CHIS:
+        chis &= ~value;
+        break;
+    }
+}
+
+// Ends the access of a context at its next access or the end of the handler, a DR access made right
+//  after FR showed data and not stored to was a read, which takes the character out of the rx fifo
+void closeLatch(LATCH* latch)
+{
+    syncLatch(latch);
+    if (latch->open && latch->reading && rxFifo.count != 0)
+    {
+        popFifo(&rxFifo);
+        if (rxFifo.count < getRxTrigger())
+            ris &= ~UART_RIS_RXRIS;
+        if (rxFifo.count == 0)
+            ris &= ~UART_RIS_RTRIS;
+    }
+    latch->open = false;
+}
+
+// Reads the register for the latch of the accessing context, with the read side effects
+volatile uint32_t* accessUart0Register(uint8_t reg)
+{
+    LATCH* latch = inHandler ? &handlerLatch : &threadLatch;
+    sigset_t block, previous;
+    uint32_t value = 0;
+    sigemptyset(&block);
+    sigaddset(&block, SIGUSR1);
+    pthread_sigmask(SIG_BLOCK, &block, &previous);
+    pthread_mutex_lock(&modelMutex);
+    closeLatch(latch);
+    switch (reg)
+    {
+    case UART0_REG_DR:
+        if (latch->armed && rxFifo.count != 0)
+            value = rxFifo.data[rxFifo.head];
+        break;
+    case UART0_REG_FR:
+        value = (txFifo.count == FIFO_SIZE ? UART_FR_TXFF : 0) | (txFifo.count == 0 ? UART_FR_TXFE : 0)
+              | (rxFifo.count == FIFO_SIZE ? UART_FR_RXFF : 0) | (rxFifo.count == 0 ? UART_FR_RXFE : 0)
+              | (txFifo.count != 0 ? UART_FR_BUSY : 0);
+        break;
+    case UART0_REG_MIS:
+        value = ris & hostUart0Im;
+        break;
+    case UART0_REG_CHIS:
+        value = chis;
+        break;
+    }
+    latch->reading = reg == UART0_REG_DR && latch->armed && rxFifo.count != 0;
+    latch->armed = inHandler && reg == UART0_REG_FR && rxFifo.count != 0;
+    latch->reg = reg;
+    latch->value = value | LATCH_OPEN;
+    latch->open = true;
+    pthread_mutex_unlock(&modelMutex);
+    pthread_sigmask(SIG_SETMASK, &previous, NULL);
+    return &latch->value;
+}
+
+bool isInterruptPending(void)
+{
+    if (!(hostNvicEn0 & (1 << (INT_UART0-16))))
+        return false;
+    return (ris & hostUart0Im) != 0 || (chis & TX_DMA_MASK) != 0;
+}
+
+// SIGUSR1, the UART0 interrupt
+void uartInterrupt(int signal)
+{
+    bool pending;
+    inHandler = 1;
+    while (true)
+    {
+        pthread_mutex_lock(&modelMutex);
+        closeLatch(&handlerLatch);
+        pending = isInterruptPending();
+        pthread_mutex_unlock(&modelMutex);
+        if (!pending)
+            break;
+        hostStats.interrupts++;
+        uart0Isr();
+    }
+    inHandler = 0;
+}
+
+// Nanoseconds per character (start, 8 data and stop bits) at the baud rate in IBRD/FBRD
+uint64_t getCharacterNs(void)
+{
+    uint64_t divisorTimes64 = hostUart0Ibrd * 64 + hostUart0Fbrd;
+    uint64_t clocksPerBit = hostUart0Ctl & UART_CTL_HSE ? 8 : 16;
+    if (divisorTimes64 == 0)
+        divisorTimes64 = 21 * 64 + 45;
+    return 10 * 1000000000ULL * clocksPerBit * divisorTimes64 / (40000000ULL * 64);
+}
+
+// Lets uDMA channel 9 fill the tx fifo, completion raises the UART0 interrupt
+void runTxDma(void)
+{
+    volatile uint32_t* entry;
+    uint32_t control, remaining;
+    const char* source;
+    if (!(hostUdmaEnaset & TX_DMA_MASK) || !(hostUart0Dmactl & UART_DMACTL_TXDMAE) || !(hostUdmaCfg & UDMA_CFG_MASTEN))
+        return;
+    entry = (volatile uint32_t*)(uintptr_t)hostUdmaCtlbase + TX_DMA_CHANNEL*4;
+    control = entry[2];
+    if ((control & UDMA_CHCTL_XFERMODE_M) == UDMA_CHCTL_XFERMODE_STOP)
+        return;
+    remaining = ((control & UDMA_CHCTL_XFERSIZE_M) >> UDMA_CHCTL_XFERSIZE_S) + 1;
+    source = (const char*)(uintptr_t)entry[0] - (remaining - 1);
+    while (remaining != 0 && txFifo.count < FIFO_SIZE)
+    {
+        transmitCharacter(*source++);
+        hostStats.dmaBytes++;
+        remaining--;
+    }
+    if (remaining == 0)
+    {
+        entry[2] = control & ~(UDMA_CHCTL_XFERMODE_M | UDMA_CHCTL_XFERSIZE_M);
+        hostUdmaEnaset &= ~TX_DMA_MASK;
+        chis |= TX_DMA_MASK;
+    }
+    else
+        entry[2] = (control & ~UDMA_CHCTL_XFERSIZE_M) | ((remaining - 1) << UDMA_CHCTL_XFERSIZE_S);
+}
+
+void receiveCharacter(uint8_t c)
+{
+    if (rxFifo.count == FIFO_SIZE)
+    {
+        overrunNext = true;
+        hostStats.rxOverruns++;
+        return;
+    }
+    pushFifo(&rxFifo, c | (overrunNext ? UART_DR_OE : 0));
+    overrunNext = false;
+    idleChars = 0;
+    if (rxFifo.count == getRxTrigger())
+        ris |= UART_RIS_RXRIS;
+}
+
+// One character time of the line
+void runCharacterTime(void)
+{
+    bool received = false;
+    bool rxHeld;
+    uint8_t c;
+    if (!(hostUart0Ctl & UART_CTL_UARTEN))
+        return;
+    runTxDma();
+    rxHeld = rxFifo.count == FIFO_SIZE && isInterruptPending();
+    if (txFifo.count != 0 && (hostUart0Ctl & UART_CTL_TXE) && !(loopback && rxHeld))
+    {
+        c = popFifo(&txFifo);
+        if (txFifo.count == getTxTrigger())
+            ris |= UART_RIS_TXRIS;
+        hostStats.txCharacters++;
+        if (loopback)
+        {
+            receiveCharacter(c);
+            received = true;
+        }
+        else
+        {
+            if (hostFlowControl && (c == XOFF || c == XON))
+                hostPaused = c == XOFF;
+            if (fromDeviceWrite - fromDeviceRead < HOST_BUFFER_SIZE)
+                fromDevice[fromDeviceWrite++ % HOST_BUFFER_SIZE] = c;
+        }
+    }
+    if (!loopback && !hostPaused && toDeviceRead != toDeviceWrite && (hostUart0Ctl & UART_CTL_RXE)
+            && !rxHeld)
+    {
+        receiveCharacter(toDevice[toDeviceRead++ % HOST_BUFFER_SIZE]);
+        received = true;
+    }
+    if (!received && rxFifo.count != 0 && ++idleChars == RX_TIMEOUT_CHARS)
+        ris |= UART_RIS_RTRIS;
+}
+
+void* runDevice(void* argument)
+{
+    struct timespec next, now;
+    uint64_t characterNs, lateNs;
+    uint8_t n;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    while (running)
+    {
+        pthread_mutex_lock(&modelMutex);
+        characterNs = getCharacterNs();
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        lateNs = (now.tv_sec - next.tv_sec) * 1000000000LL + (now.tv_nsec - next.tv_nsec);
+        for (n = 0; n <= lateNs / characterNs && n < MAX_CATCH_UP; n++)
+            runCharacterTime();
+        syncLatch(&threadLatch);
+        syncLatch(&handlerLatch);
+        if (isInterruptPending())
+            pthread_kill(cpuThread, SIGUSR1);
+        pthread_mutex_unlock(&modelMutex);
+        next.tv_nsec += n * characterNs;
+        while (next.tv_nsec >= 1000000000)
+        {
+            next.tv_nsec -= 1000000000;
+            next.tv_sec++;
+        }
+        if (n == MAX_CATCH_UP)
+            next = now;                 // too late to catch up, the line was idle meanwhile
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+    }
+    return NULL;
+}
+
+void startUartHost(bool loopbackLine)
+{
+    struct sigaction action;
+    sigset_t block;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = uartInterrupt;
+    action.sa_flags = SA_RESTART;
+    sigaction(SIGUSR1, &action, NULL);
+    loopback = loopbackLine;
+    cpuThread = pthread_self();
+    running = true;
+    sigemptyset(&block);
+    sigaddset(&block, SIGUSR1);
+    pthread_sigmask(SIG_BLOCK, &block, NULL);   // inherited by the device thread
+    pthread_create(&deviceThread, NULL, runDevice, NULL);
+    pthread_sigmask(SIG_UNBLOCK, &block, NULL);
+}
+
+void stopUartHost(void)
+{
+    running = false;
+    pthread_join(deviceThread, NULL);
+}
+
+// Queues characters for the host to send, returns how many fit
+uint32_t sendToUart0(const char* data, uint32_t length)
+{
+    uint32_t i;
+    pthread_mutex_lock(&modelMutex);
+    for (i = 0; i < length && toDeviceWrite - toDeviceRead < HOST_BUFFER_SIZE; i++)
+        toDevice[toDeviceWrite++ % HOST_BUFFER_SIZE] = data[i];
+    pthread_mutex_unlock(&modelMutex);
+    return i;
+}
+
+// Takes up to size characters the host received, returns how many
+uint32_t receiveFromUart0(char* data, uint32_t size)
+{
+    uint32_t i;
+    pthread_mutex_lock(&modelMutex);
+    for (i = 0; i < size && fromDeviceRead != fromDeviceWrite; i++)
+        data[i] = fromDevice[fromDeviceRead++ % HOST_BUFFER_SIZE];
+    pthread_mutex_unlock(&modelMutex);
+    return i;
+}
+
+// The host stops sending at XOFF and resumes at XON, both still reach receiveFromUart0
+void setUartHostFlowControl(bool enable)
+{
+    pthread_mutex_lock(&modelMutex);
+    hostFlowControl = enable;
+    hostPaused = false;
+    pthread_mutex_unlock(&modelMutex);
+}
+
+// True once everything the host sent went into the rx fifo and the tx fifo and uDMA are empty
+bool isUartHostIdle(void)
+{
+    bool idle;
+    pthread_mutex_lock(&modelMutex);
+    idle = toDeviceRead == toDeviceWrite && txFifo.count == 0 && !(hostUdmaEnaset & TX_DMA_MASK);
+    pthread_mutex_unlock(&modelMutex);
+    return idle;
+}
+
+void getUartHostStats(UART_HOST_STATS* stats)
+{
+    pthread_mutex_lock(&modelMutex);
+    *stats = hostStats;
+    pthread_mutex_unlock(&modelMutex);
+}
@@ -0,0 +1,37 @@
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target uC:       host (POSIX)
+// System Clock:    -
+
+#ifndef UARTHOST_H_
+#define UARTHOST_H_
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+typedef struct _UART_HOST_STATS
+{
+    uint32_t txCharacters;              // characters sent on the line
+    uint32_t dmaBytes;                  // of those, moved by uDMA
+    uint32_t rxOverruns;                // characters lost to a full rx fifo
+    uint32_t txLost;                    // DR writes to a full tx fifo
+    uint32_t interrupts;                // uart0Isr runs
+} UART_HOST_STATS;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+// the UART0 model of uarthost.c, these only exist in host builds
+void startUartHost(bool loopbackLine);
+void stopUartHost(void);
+uint32_t sendToUart0(const char* data, uint32_t length);
+uint32_t receiveFromUart0(char* data, uint32_t size);
+void setUartHostFlowControl(bool enable);
+bool isUartHostIdle(void);
+void getUartHostStats(UART_HOST_STATS* stats);
+
+#endif
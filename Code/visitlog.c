@@ -0,0 +1,287 @@
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target uC:       TM4C123GH6PM
+// System Clock:    -
+
+// Append-only visit log over LOG_BLOCKS EEPROM blocks starting at EE_LOG
+//   word 0 of a block: sequence number, one higher than the block before it in ring order
+//   word 1: minute (RTC seconds / 60) of the first visit in the block
+//   words 2-15: 56 byte stream of minute deltas to the previous visit, little endian within a word
+//
+// A delta is 0-2 continuation bytes (0x80 | base 127 digit, most significant first) and a final byte
+//   (0x00-0x7F, low 7 bits), so a byte is never 0xFF and the erased bytes mark the end of the stream
+//   1 byte: up to 2 hours, 2 bytes: 11 days, 3 bytes: 3.9 years; a longer gap or a clock set
+//   backwards starts a new block
+//
+// The head is found on boot by binary search: walking the ring from block 0, headers count up by one
+//   until the newest block, so "header(i) == header(0) + i" holds for a prefix of the blocks only
+// A block is erased before its new header is written, a reset in between leaves its old (oldest)
+//   sequence number in place and the block is simply opened again
+// A word is rewritten as bytes are added to it, about 5 writes per word and pass over the ring, which
+//   at one visit per minute still keeps a word far under its 500k cycle endurance
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "eeprom.h"
+#include "layout.h"
+#include "visitlog.h"
+
+#define LOG_ERASED          0xFFFFFFFF
+#define LOG_STREAM          2           // first word of the delta stream
+#define LOG_STREAM_BYTES    56
+#define LOG_CONTINUE        0x80
+#define LOG_DIGIT           127         // base of the continuation bytes
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+// Written by timer4ISR through appendVisit(), read by the shell
+volatile uint8_t logHeadBlock;          // block holding the newest visit
+volatile uint8_t logHeadBytes;          // stream bytes used in the head block
+volatile uint8_t logUsedBlocks;         // blocks holding visits, LOG_BLOCKS once the ring has wrapped
+volatile uint32_t logSequence;          // sequence number of the head block
+volatile uint32_t logLastMinute;        // newest visit
+volatile uint32_t logTail;              // stream word being filled in the head block
+volatile uint16_t logVisitCount;
+volatile uint8_t logBlockCount[LOG_BLOCKS];
+
+uint32_t visitMinutes[LOG_BLOCK_VISITS];    // one decoded block, main loop only
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+// Encodes a minute delta, returns its length in bytes or 0 when it needs more than LOG_DELTA_BYTES
+uint8_t encodeVisitDelta(uint32_t delta, uint8_t* out)
+{
+    uint8_t digits[LOG_DELTA_BYTES-1];
+    uint8_t n = 0, i;
+    uint32_t high = delta >> 7;
+    while (high != 0)
+    {
+        if (n == LOG_DELTA_BYTES-1)
+            return 0;
+        digits[n++] = high % LOG_DIGIT;
+        high /= LOG_DIGIT;
+    }
+    for (i = 0; i < n; i++)
+        out[i] = LOG_CONTINUE | digits[n-1-i];
+    out[n] = delta & 0x7F;
+    return n + 1;
+}
+
+uint8_t getStreamByte(const uint32_t* words, uint8_t position)
+{
+    return words[LOG_STREAM + position/4] >> (8 * (position % 4));
+}
+
+// Decodes a block (16 words) into minutes oldest first, returns the visit count
+//  used gets the stream bytes holding complete deltas, a delta cut short by a reset is ignored
+uint8_t decodeVisitBlock(const uint32_t* words, uint32_t* minutes, uint8_t* used)
+{
+    uint8_t count = 0, position = 0, b;
+    uint32_t value = 0;
+    *used = 0;
+    if (words[1] == LOG_ERASED)
+        return 0;
+    minutes[count++] = words[1];
+    while (position < LOG_STREAM_BYTES)
+    {
+        b = getStreamByte(words, position++);
+        if (b == 0xFF)
+            break;
+        if (b & LOG_CONTINUE)
+        {
+            value = value * LOG_DIGIT + (b & 0x7F);
+            continue;
+        }
+        minutes[count] = minutes[count-1] + value * 128 + b;
+        count++;
+        value = 0;
+        *used = position;
+    }
+    return count;
+}
+
+// Builds a block from minutes oldest first, a gap that cannot be encoded restarts the block at that
+//  visit so the newest visits are kept, visits past the end of the stream are dropped
+void packVisitBlock(uint32_t sequence, const uint32_t* minutes, uint8_t count, uint32_t* words)
+{
+    uint8_t bytes[LOG_DELTA_BYTES];
+    uint8_t i, j, n, position = 0;
+    for (i = 0; i < 16; i++)
+        words[i] = LOG_ERASED;
+    words[0] = sequence;
+    for (i = 0; i < count; i++)
+    {
+        n = 0;
+        if (i != 0 && minutes[i] >= minutes[i-1])
+            n = encodeVisitDelta(minutes[i] - minutes[i-1], bytes);
+        if (n == 0)
+        {
+            for (j = LOG_STREAM; j < 16; j++)
+                words[j] = LOG_ERASED;
+            words[1] = minutes[i];
+            position = 0;
+            continue;
+        }
+        if (position + n > LOG_STREAM_BYTES)
+            return;
+        for (j = 0; j < n; j++, position++)
+        {
+            words[LOG_STREAM + position/4] &= ~((uint32_t)0xFF << (8 * (position % 4)));
+            words[LOG_STREAM + position/4] |= (uint32_t)bytes[j] << (8 * (position % 4));
+        }
+    }
+}
+
+// Erases the whole log and stores visits (RTC seconds, oldest first), erased entries are skipped
+void formatVisitLog(const uint32_t* visits, uint8_t count)
+{
+    uint32_t words[16];
+    uint8_t i, n = 0;
+    for (i = 1; i < LOG_BLOCKS; i++)
+        writeEeprom(EE_LOG + 16*i, LOG_ERASED);
+    for (i = 0; i < count && n < LOG_BLOCK_VISITS; i++)
+        if (visits[i] != LOG_ERASED)
+            visitMinutes[n++] = visits[i] / 60;
+    packVisitBlock(0, visitMinutes, n, words);
+    writeEepromBlock(EE_LOG, words, 16);
+}
+
+// Finds the head block and write position and counts the visits, call once after initLayout()
+void initVisitLog(void)
+{
+    uint32_t words[16];
+    uint32_t first = readEeprom(EE_LOG);
+    uint8_t low, high, middle, i, used;
+
+    logUsedBlocks = 0;
+    logHeadBlock = LOG_BLOCKS-1;        // the first visit opens block 0 with sequence number 0
+    logSequence = LOG_ERASED;
+    logVisitCount = 0;
+    for (i = 0; i < LOG_BLOCKS; i++)
+        logBlockCount[i] = 0;
+    if (first == LOG_ERASED)
+        return;
+
+    // last block of the counting run
+    low = 0;
+    high = LOG_BLOCKS-1;
+    while (low < high)
+    {
+        middle = (low + high + 1) / 2;
+        if (readEeprom(EE_LOG + 16*middle) == first + middle)
+            low = middle;
+        else
+            high = middle - 1;
+    }
+    logHeadBlock = low;
+    logSequence = first + low;
+    logUsedBlocks = LOG_BLOCKS;
+    if (low != LOG_BLOCKS-1 && readEeprom(EE_LOG + 16*(low+1)) == LOG_ERASED)
+        logUsedBlocks = low + 1;        // ring has not wrapped yet
+
+    for (i = 0; i < logUsedBlocks; i++)
+    {
+        readEepromBlock(EE_LOG + 16*i, words, 16);
+        logBlockCount[i] = decodeVisitBlock(words, visitMinutes, &used);
+        logVisitCount += logBlockCount[i];
+        if (i == logHeadBlock)
+        {
+            logHeadBytes = used;
+            if (logBlockCount[i] != 0)
+                logLastMinute = visitMinutes[logBlockCount[i] - 1];
+            logTail = LOG_ERASED;
+            if (used % 4 != 0)          // keep the complete bytes of the partly filled word
+                logTail = words[LOG_STREAM + used/4] | (LOG_ERASED << (8 * (used % 4)));
+        }
+    }
+}
+
+// Appends one visit (RTC seconds, stored to the minute), the writes are queued so this is safe to
+//  call from an isr
+void appendVisit(uint32_t seconds)
+{
+    uint8_t bytes[LOG_DELTA_BYTES];
+    uint8_t i, n = 0, position, shift;
+    uint32_t minute = seconds / 60;
+    uint16_t address;
+
+    if (logUsedBlocks != 0 && logBlockCount[logHeadBlock] != 0 && minute >= logLastMinute)
+        n = encodeVisitDelta(minute - logLastMinute, bytes);
+    if (n != 0 && logHeadBytes + n <= LOG_STREAM_BYTES)
+    {
+        address = EE_LOG + 16*logHeadBlock + LOG_STREAM;
+        for (i = 0; i < n; i++)
+        {
+            position = logHeadBytes++;
+            shift = 8 * (position % 4);
+            logTail = (logTail & ~((uint32_t)0xFF << shift)) | ((uint32_t)bytes[i] << shift);
+            if (position % 4 == 3 || i == n-1)
+                queueEepromWrite(address + position/4, logTail);
+            if (position % 4 == 3)
+                logTail = LOG_ERASED;
+        }
+    }
+    else
+    {
+        // new block, unless the head block lost its first visit to a reset right after being opened
+        if (logUsedBlocks == 0 || logBlockCount[logHeadBlock] != 0)
+        {
+            logHeadBlock = (logHeadBlock + 1) % LOG_BLOCKS;
+            for (i = 1; i < 16; i++)
+                queueEepromWrite(EE_LOG + 16*logHeadBlock + i, LOG_ERASED);
+            queueEepromWrite(EE_LOG + 16*logHeadBlock, ++logSequence);
+            if (logUsedBlocks < LOG_BLOCKS)
+                logUsedBlocks++;
+            logVisitCount -= logBlockCount[logHeadBlock];
+            logBlockCount[logHeadBlock] = 0;
+        }
+        queueEepromWrite(EE_LOG + 16*logHeadBlock + 1, minute);
+        logHeadBytes = 0;
+        logTail = LOG_ERASED;
+    }
+    logLastMinute = minute;
+    logBlockCount[logHeadBlock]++;
+    logVisitCount++;
+}
+
+uint16_t getVisitCount(void)
+{
+    return logVisitCount;
+}
+
+// Copies up to count visit times (RTC seconds) newest first, starting age visits back from the newest
+//  each block is read with one burst and decoded once, returns the number copied
+uint16_t readVisits(uint16_t age, uint32_t* seconds, uint16_t count)
+{
+    uint32_t words[16];
+    uint8_t block = logHeadBlock;
+    uint8_t blocks, inBlock, used;
+    uint16_t copied = 0;
+    int16_t k;
+    for (blocks = 0; blocks < logUsedBlocks && copied < count; blocks++)
+    {
+        inBlock = logBlockCount[block];
+        if (age >= inBlock)
+            age -= inBlock;
+        else
+        {
+            readEepromBlock(EE_LOG + 16*block, words, 16);
+            decodeVisitBlock(words, visitMinutes, &used);
+            for (k = inBlock - 1 - age; k >= 0 && copied < count; k--)
+                seconds[copied++] = visitMinutes[k] * 60;
+            age = 0;
+        }
+        block = (block + LOG_BLOCKS - 1) % LOG_BLOCKS;
+    }
+    return copied;
+}
@@ -0,0 +1,30 @@
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target uC:       TM4C123GH6PM
+// System Clock:    -
+
+#ifndef VISITLOG_H_
+#define VISITLOG_H_
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#define LOG_DELTA_BYTES     3           // longest encoded minute delta
+#define LOG_BLOCK_VISITS    57          // first visit plus 56 one byte deltas
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+uint8_t encodeVisitDelta(uint32_t delta, uint8_t* out);
+uint8_t decodeVisitBlock(const uint32_t* words, uint32_t* minutes, uint8_t* used);
+void formatVisitLog(const uint32_t* visits, uint8_t count);
+void initVisitLog(void);
+void appendVisit(uint32_t seconds);
+uint16_t getVisitCount(void);
+uint16_t readVisits(uint16_t age, uint32_t* seconds, uint16_t count);
+
+#endif